@@ -0,0 +1,289 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryBenchmarkCommandlet.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryBenchmarkCommandlet.h"
+#include "CollisionQueryTestActor.h"
+#include "CollisionQueryRecording.h"
+#include "CollisionQueryTestStats.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCollisionQueryBenchmark, Log, All);
+
+namespace CollisionQueryBenchmark
+{
+	struct FReportRow
+	{
+		FString Actor;
+		FString Query;
+		int32 Iterations = 0;
+		double QueriesPerSecond = 0.0;
+		FCollisionQueryLatencySummary Latency;
+		bool bResult = false;
+		int32 NumHits = 0;
+	};
+
+	static FString EscapeJson(const FString& String)
+	{
+		return String.Replace(TEXT("\\"), TEXT("\\\\")).Replace(TEXT("\""), TEXT("\\\""));
+	}
+
+	static FString MakeCSV(const FString& MapName, const TArray<FReportRow>& Rows)
+	{
+		FString Out = TEXT("Map,Actor,Query,Iterations,QueriesPerSecond,MinUs,AvgUs,P95Us,P99Us,MaxUs,Result,NumHits\n");
+		for (const FReportRow& Row : Rows)
+		{
+			Out += FString::Printf(TEXT("%s,%s,%s,%d,%.1f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d\n"),
+				*MapName, *Row.Actor, *Row.Query, Row.Iterations, Row.QueriesPerSecond,
+				Row.Latency.Min * 1e6, Row.Latency.Avg * 1e6, Row.Latency.P95 * 1e6, Row.Latency.P99 * 1e6, Row.Latency.Max * 1e6,
+				Row.bResult ? 1 : 0, Row.NumHits);
+		}
+		return Out;
+	}
+
+	static FString MakeJSON(const FString& MapName, const TArray<FReportRow>& Rows)
+	{
+		FString Out = FString::Printf(TEXT("{\n\t\"map\": \"%s\",\n\t\"results\": [\n"), *EscapeJson(MapName));
+		for (int32 RowIdx = 0; RowIdx < Rows.Num(); ++RowIdx)
+		{
+			const FReportRow& Row = Rows[RowIdx];
+			Out += FString::Printf(TEXT("\t\t{ \"actor\": \"%s\", \"query\": \"%s\", \"iterations\": %d, \"queriesPerSecond\": %.1f, \"minUs\": %.2f, \"avgUs\": %.2f, \"p95Us\": %.2f, \"p99Us\": %.2f, \"maxUs\": %.2f, \"result\": %s, \"numHits\": %d }%s\n"),
+				*EscapeJson(Row.Actor), *EscapeJson(Row.Query), Row.Iterations, Row.QueriesPerSecond,
+				Row.Latency.Min * 1e6, Row.Latency.Avg * 1e6, Row.Latency.P95 * 1e6, Row.Latency.P99 * 1e6, Row.Latency.Max * 1e6,
+				Row.bResult ? TEXT("true") : TEXT("false"), Row.NumHits, RowIdx + 1 < Rows.Num() ? TEXT(",") : TEXT(""));
+		}
+		Out += TEXT("\t]\n}\n");
+		return Out;
+	}
+
+	static UWorld* LoadWorld(const FString& MapName)
+	{
+		UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (!World)
+		{
+			UE_LOG(LogCollisionQueryBenchmark, Error, TEXT("Failed to load map %s"), *MapName);
+			return nullptr;
+		}
+
+		World->AddToRoot();
+		if (!World->bIsWorldInitialized)
+		{
+			UWorld::InitializationValues IVS;
+			IVS.RequiresHitProxies(false)
+				.ShouldSimulatePhysics(false)
+				.EnableTraceCollision(true)
+				.CreateNavigation(false)
+				.CreateAISystem(false)
+				.AllowAudioPlayback(false)
+				.CreatePhysicsScene(true);
+			World->InitWorld(IVS);
+		}
+		World->UpdateWorldComponents(true, false);
+		World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+		return World;
+	}
+
+	/** Tears down a world from LoadWorld, along with its physics scene and components. */
+	static void UnloadWorld(UWorld* World)
+	{
+		World->RemoveFromRoot();
+		World->CleanupWorld();
+		World->DestroyWorld(false);
+	}
+
+	static int32 Replay(const FString& RecordingPath, FString MapName)
+	{
+		FCollisionQueryRecording Recording;
+		if (!Recording.Load(RecordingPath))
+		{
+			return 1;
+		}
+
+		if (MapName.IsEmpty())
+		{
+			MapName = Recording.MapName;
+		}
+
+		UWorld* World = LoadWorld(MapName);
+		if (!World)
+		{
+			return 1;
+		}
+
+		UE_LOG(LogCollisionQueryBenchmark, Display, TEXT("Replaying %d queries recorded on %s with engine version %s"), Recording.Records.Num(), *Recording.MapName, *Recording.EngineVersion);
+
+		const FCollisionQueryReplayReport Report = Recording.Replay(World);
+
+		UnloadWorld(World);
+
+		for (const FString& Diff : Report.Diffs)
+		{
+			UE_LOG(LogCollisionQueryBenchmark, Warning, TEXT("%s"), *Diff);
+		}
+
+		const double RecordedAvg = Report.NumQueries > 0 ? Report.RecordedTime / Report.NumQueries : 0.0;
+		const double ReplayedAvg = Report.NumQueries > 0 ? Report.ReplayedTime / Report.NumQueries : 0.0;
+		const double LatencyDelta = RecordedAvg > 0.0 ? (ReplayedAvg - RecordedAvg) / RecordedAvg * 100.0 : 0.0;
+
+		UE_LOG(LogCollisionQueryBenchmark, Display, TEXT("Replayed %d queries: %d results differ, avg latency %.2fus -> %.2fus (%+.1f%%)"),
+			Report.NumQueries, Report.NumDiffs, RecordedAvg * 1e6, ReplayedAvg * 1e6, LatencyDelta);
+
+		return Report.NumDiffs > 0 ? 1 : 0;
+	}
+}
+
+UCollisionQueryBenchmarkCommandlet::UCollisionQueryBenchmarkCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UCollisionQueryBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace CollisionQueryBenchmark;
+
+	FString MapName;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+
+	FString RecordingPath;
+	if (FParse::Value(*Params, TEXT("Replay="), RecordingPath))
+	{
+		return Replay(RecordingPath, MapName);
+	}
+
+	if (MapName.IsEmpty())
+	{
+		UE_LOG(LogCollisionQueryBenchmark, Error, TEXT("No map specified. Usage: -run=CollisionQueryBenchmark -Map=/Game/Maps/MyMap [-Iterations=1000] [-Output=Report.csv|.json]"));
+		return 1;
+	}
+
+	int32 Iterations = 1000;
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	Iterations = FMath::Max(Iterations, 1);
+
+	const bool bStress = FParse::Param(*Params, TEXT("Stress"));
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	int32 MaxThreads = 0;
+	FParse::Value(*Params, TEXT("MaxThreads="), MaxThreads);
+
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("CollisionQueryBenchmark") / FPaths::GetBaseFilename(MapName) + TEXT(".csv");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	UWorld* World = LoadWorld(MapName);
+	if (!World)
+	{
+		return 1;
+	}
+
+	TArray<FReportRow> Rows;
+	TArray<FCollisionQueryTestDesc> Variants;
+	TArray<double> Samples;
+	FCollisionQueryTestResult Result;
+	FCollisionQueryStressTest StressTest;
+	TArray<int32> ThreadCounts;
+	FCollisionQueryStressTest::GetThreadCounts(MaxThreads, ThreadCounts);
+
+	for (TActorIterator<ACollisionQueryTestActor> It(World); It; ++It)
+	{
+		const ACollisionQueryTestActor* Actor = *It;
+
+		const FVector Start = Actor->GetActorLocation();
+		const FVector End = Actor->EndComponent->GetComponentLocation();
+		const FQuat Rot = Actor->GetActorQuat();
+
+		if (bStress)
+		{
+			const FCollisionQueryTestDesc Desc = Actor->MakeQueryDesc();
+			StressTest.Generate(Seed, FBox(Start - Actor->StressExtent, Start + Actor->StressExtent), Iterations);
+
+			// warm up caches before measuring
+			StressTest.Run(World, Desc, 1);
+
+			for (const int32 NumThreads : ThreadCounts)
+			{
+				const FCollisionQueryStressTestResult StressResult = StressTest.Run(World, Desc, NumThreads);
+
+				FReportRow& Row = Rows.AddDefaulted_GetRef();
+				Row.Actor = Actor->GetActorNameOrLabel();
+				Row.Query = FString::Printf(TEXT("%s Stress Seed%d %dThreads"), *Desc.ToString(), Seed, StressResult.NumThreads);
+				if (StressResult.NumThreadsRan < StressResult.NumThreads)
+				{
+					// busy workers left their shares to fewer threads, so the row does not measure the thread count it is for
+					Row.Query += FString::Printf(TEXT(" (%dRan)"), StressResult.NumThreadsRan);
+					UE_LOG(LogCollisionQueryBenchmark, Warning, TEXT("%s: only %d of %d threads ran queries"), *Row.Actor, StressResult.NumThreadsRan, StressResult.NumThreads);
+				}
+				Row.Iterations = StressResult.NumQueries;
+				Row.QueriesPerSecond = StressResult.QueriesPerSecond;
+				Row.Latency = StressResult.Latency;
+				Row.bResult = StressResult.NumHits > 0;
+				Row.NumHits = StressResult.NumHits;
+
+				UE_LOG(LogCollisionQueryBenchmark, Display, TEXT("%s: %s: %.0f queries/s, %s"), *Row.Actor, *Row.Query, Row.QueriesPerSecond, *Row.Latency.ToString());
+			}
+			continue;
+		}
+
+		Variants.Reset();
+		Actor->MakeQueryDesc().GetVariants(Variants);
+
+		for (const FCollisionQueryTestDesc& Desc : Variants)
+		{
+			// warm up caches before measuring
+			Desc.Execute(World, Start, End, Rot, Result);
+
+			Samples.Reset(Iterations);
+			double TotalTime = 0.0;
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Desc.Execute(World, Start, End, Rot, Result);
+				Samples.Add(Result.ExecutionTime);
+				TotalTime += Result.ExecutionTime;
+			}
+
+			FReportRow& Row = Rows.AddDefaulted_GetRef();
+			Row.Actor = Actor->GetActorNameOrLabel();
+			Row.Query = Desc.ToString();
+			Row.Iterations = Iterations;
+			Row.QueriesPerSecond = TotalTime > 0.0 ? Iterations / TotalTime : 0.0;
+			Row.Latency = FCollisionQueryLatencyHistory::Summarize(Samples);
+			Row.bResult = Result.bResult;
+			Row.NumHits = FMath::Max3(Result.Hits.Num(), Result.Overlaps.Num(), Result.bResult ? 1 : 0);
+
+			UE_LOG(LogCollisionQueryBenchmark, Display, TEXT("%s: %s: %.0f queries/s, %s"), *Row.Actor, *Row.Query, Row.QueriesPerSecond, *Row.Latency.ToString());
+		}
+	}
+
+	if (Rows.Num() == 0)
+	{
+		UE_LOG(LogCollisionQueryBenchmark, Warning, TEXT("No CollisionQueryTestActors found in %s"), *MapName);
+	}
+
+	const bool bJSON = FPaths::GetExtension(OutputPath).Equals(TEXT("json"), ESearchCase::IgnoreCase);
+	const FString Report = bJSON ? MakeJSON(MapName, Rows) : MakeCSV(MapName, Rows);
+
+	UnloadWorld(World);
+
+	if (!FFileHelper::SaveStringToFile(Report, *OutputPath))
+	{
+		UE_LOG(LogCollisionQueryBenchmark, Error, TEXT("Failed to write report to %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogCollisionQueryBenchmark, Display, TEXT("Wrote %d results to %s"), Rows.Num(), *OutputPath);
+	return 0;
+}
@@ -0,0 +1,44 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryBenchmarkCommandlet.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "CollisionQueryBenchmarkCommandlet.generated.h"
+
+/**
+ * Loads a map and benchmarks the query of every CollisionQueryTestActor in it, in every single/multi/test, by and
+ * simple/complex combination. Writes a CSV or JSON report (depending on the extension of the output file) of
+ * queries per second and latency percentiles. Does not need a renderer or debug draw, so can be run with -nullrhi.
+ *
+ * Usage: -run=CollisionQueryBenchmark -Map=/Game/Maps/MyMap [-Iterations=1000] [-Output=Path/To/Report.csv|.json]
+ *
+ * With -Stress, instead runs Iterations random queries inside the StressExtent of each actor, generated from -Seed, from
+ * 1, 2, 4 ... -MaxThreads threads at once (all worker threads by default), and reports each thread count as a row.
+ *
+ * Usage: -run=CollisionQueryBenchmark -Map=/Game/Maps/MyMap -Stress [-Seed=0] [-MaxThreads=0] [-Iterations=1000] [-Output=...]
+ *
+ * With -Replay, instead re-runs the queries of a recording made with CollisionQueryTest.Record against the map it was
+ * recorded on (or -Map if given), logs any results which differ and the change in average latency, and returns non-zero
+ * if any results differ.
+ *
+ * Usage: -run=CollisionQueryBenchmark -Replay=Path/To/Recording.cqrec [-Map=/Game/Maps/MyMap]
+ */
+UCLASS()
+class UCollisionQueryBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCollisionQueryBenchmarkCommandlet(const FObjectInitializer& ObjectInitializer);
+
+	virtual int32 Main(const FString& Params) override;
+};
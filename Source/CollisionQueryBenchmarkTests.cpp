@@ -0,0 +1,472 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryBenchmarkTests.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "CollisionQueryTestActor.h"
+#include "CollisionQueryDrawDebugHelpers.h"
+#include "CollisionQueryTestStats.h"
+#include "Components/BoxComponent.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarCollisionQueryTestBenchmarkFieldCount(
+	TEXT("CollisionQueryTest.BenchmarkFieldCount"),
+	8,
+	TEXT("Number of objects along each side of the field built by the CollisionQueryTest.Benchmark.Queries automation tests."));
+
+static TAutoConsoleVariable<float> CVarCollisionQueryTestBenchmarkFieldSpacing(
+	TEXT("CollisionQueryTest.BenchmarkFieldSpacing"),
+	150.f,
+	TEXT("Distance between the objects of the field built by the CollisionQueryTest.Benchmark.Queries automation tests. Smaller is denser."));
+
+static TAutoConsoleVariable<int32> CVarCollisionQueryTestBenchmarkIterations(
+	TEXT("CollisionQueryTest.BenchmarkIterations"),
+	200,
+	TEXT("Number of times each query or draw helper is run by the CollisionQueryTest.Benchmark automation tests."));
+
+static TAutoConsoleVariable<float> CVarCollisionQueryTestBenchmarkTolerance(
+	TEXT("CollisionQueryTest.BenchmarkTolerance"),
+	0.3f,
+	TEXT("Fraction by which a time measured by the CollisionQueryTest.Benchmark automation tests may exceed its baseline before the test fails."));
+
+static TAutoConsoleVariable<bool> CVarCollisionQueryTestBenchmarkUpdateBaselines(
+	TEXT("CollisionQueryTest.BenchmarkUpdateBaselines"),
+	false,
+	TEXT("Write the results of the CollisionQueryTest.Benchmark automation tests as the new baselines instead of comparing against them."));
+
+static TAutoConsoleVariable<FString> CVarCollisionQueryTestBenchmarkBaselines(
+	TEXT("CollisionQueryTest.BenchmarkBaselines"),
+	TEXT(""),
+	TEXT("Path of the baselines file the CollisionQueryTest.Benchmark automation tests compare against, relative to the project directory.\n")
+	TEXT("Empty for Build/CollisionQueryBenchmark/Baselines-<Machine>.csv if it exists, else Build/CollisionQueryBenchmark/Baselines.csv."));
+
+namespace CollisionQueryBenchmarkTests
+{
+	/**
+	 * Baselines the measurements of the tests are compared against, stored as "Key,Value" lines in a file checked in
+	 * under the project's Build directory. Times only hold for the machine they were recorded on, so each machine can
+	 * check in its own file, named after it, which is used instead of the shared one.
+	 */
+	class FBaselines
+	{
+	public:
+		FBaselines()
+			: Path(GetPath())
+		{
+			TArray<FString> Lines;
+			FFileHelper::LoadFileToStringArray(Lines, *Path);
+			for (const FString& Line : Lines)
+			{
+				FString Key, Value;
+				if (Line.Split(TEXT(","), &Key, &Value, ESearchCase::CaseSensitive, ESearchDir::FromEnd))
+				{
+					Values.Add(Key, FCString::Atod(*Value));
+				}
+			}
+		}
+
+		static FString GetPath()
+		{
+			const FString Override = CVarCollisionQueryTestBenchmarkBaselines.GetValueOnGameThread();
+			if (!Override.IsEmpty())
+			{
+				return FPaths::IsRelative(Override) ? FPaths::ProjectDir() / Override : Override;
+			}
+
+			const FString Dir = FPaths::ProjectDir() / TEXT("Build") / TEXT("CollisionQueryBenchmark");
+			const FString MachinePath = Dir / FString::Printf(TEXT("Baselines-%s.csv"), FPlatformProcess::ComputerName());
+			return FPaths::FileExists(MachinePath) ? MachinePath : Dir / TEXT("Baselines.csv");
+		}
+
+		/**
+		 * Fails the test if Value exceeds the baseline by more than Tolerance, as a fraction of the baseline, or if there is
+		 * no baseline to compare against. Records Value as the baseline instead when updating baselines.
+		 */
+		void Check(FAutomationTestBase& Test, const FString& Key, double Value, double Tolerance, const TCHAR* Units)
+		{
+			const double* Baseline = Values.Find(Key);
+			if (CVarCollisionQueryTestBenchmarkUpdateBaselines.GetValueOnGameThread())
+			{
+				Test.AddInfo(FString::Printf(TEXT("%s: %.3f%s (new baseline)"), *Key, Value, Units));
+				Values.Add(Key, Value);
+				bDirty = true;
+			}
+			else if (!Baseline)
+			{
+				Test.AddError(FString::Printf(TEXT("%s: %.3f%s has no baseline in %s, run with CollisionQueryTest.BenchmarkUpdateBaselines 1 to record one"), *Key, Value, Units, *Path));
+			}
+			else if (Value > *Baseline * (1.0 + Tolerance))
+			{
+				Test.AddError(FString::Printf(TEXT("%s: %.3f%s exceeds baseline %.3f%s by %.0f%%"), *Key, Value, Units, *Baseline, Units, (Value / *Baseline - 1.0) * 100.0));
+			}
+			else
+			{
+				Test.AddInfo(FString::Printf(TEXT("%s: %.3f%s (baseline %.3f%s)"), *Key, Value, Units, *Baseline, Units));
+			}
+		}
+
+		void Save() const
+		{
+			if (!bDirty)
+			{
+				return;
+			}
+
+			FString Out;
+			for (const TPair<FString, double>& Pair : Values)
+			{
+				Out += FString::Printf(TEXT("%s,%f\n"), *Pair.Key, Pair.Value);
+			}
+			FFileHelper::SaveStringToFile(Out, *Path);
+		}
+
+	private:
+		FString Path;
+		TMap<FString, double> Values;
+		bool bDirty = false;
+	};
+
+	/** Creates a game world outside of the engine's world list, with collision but no rendering. */
+	static UWorld* CreateWorld()
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("CollisionQueryBenchmark"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		return World;
+	}
+
+	static void DestroyWorld(UWorld* World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	/**
+	 * Fills a cube of the world centred on the origin with a FieldCount^3 grid of static colliders, jittered and rotated by
+	 * a fixed seed so that every run builds the same field. Returns false if the shape could not be created.
+	 */
+	static bool BuildField(UWorld* World, const FString& FieldType, int32 FieldCount, float FieldSpacing)
+	{
+		UStaticMesh* Mesh = nullptr;
+		if (FieldType == TEXT("Meshes"))
+		{
+			// complex queries against the cone hit its triangle mesh, simple ones its convex hull
+			Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cone.Cone"));
+			if (!Mesh)
+			{
+				return false;
+			}
+		}
+
+		AActor* FieldActor = World->SpawnActor<AActor>();
+		FRandomStream Random(0);
+
+		const float HalfSize = (FieldCount - 1) * FieldSpacing * 0.5f;
+		const float ObjectSize = FieldSpacing * 0.3f;
+
+		for (int32 X = 0; X < FieldCount; ++X)
+		{
+			for (int32 Y = 0; Y < FieldCount; ++Y)
+			{
+				for (int32 Z = 0; Z < FieldCount; ++Z)
+				{
+					const FVector Jitter = Random.GetUnitVector() * FieldSpacing * 0.2f;
+					const FVector Location = FVector(X, Y, Z) * FieldSpacing - FVector(HalfSize) + Jitter;
+					const FRotator Rotation(Random.FRandRange(0.f, 360.f), Random.FRandRange(0.f, 360.f), 0.f);
+
+					UPrimitiveComponent* Component = nullptr;
+					if (FieldType == TEXT("Boxes"))
+					{
+						UBoxComponent* Box = NewObject<UBoxComponent>(FieldActor);
+						Box->SetBoxExtent(FVector(ObjectSize), false);
+						Component = Box;
+					}
+					else if (FieldType == TEXT("Spheres"))
+					{
+						USphereComponent* Sphere = NewObject<USphereComponent>(FieldActor);
+						Sphere->SetSphereRadius(ObjectSize, false);
+						Component = Sphere;
+					}
+					else
+					{
+						UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(FieldActor);
+						MeshComponent->SetStaticMesh(Mesh);
+						MeshComponent->SetWorldScale3D(FVector(ObjectSize / 50.f)); // the basic shapes are 100 units across
+						Component = MeshComponent;
+					}
+
+					Component->SetMobility(EComponentMobility::Static);
+					Component->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+					Component->SetWorldLocationAndRotation(Location, Rotation);
+					Component->RegisterComponent();
+					FieldActor->AddInstanceComponent(Component);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/** Spawns a test actor with the given query type and shape, whose query runs from Start to End. */
+	static ACollisionQueryTestActor* SpawnQueryActor(UWorld* World, ECollisionQueryTestType Query, ECollisionQueryTestShape Shape, const FVector& Start, const FVector& End, float ShapeSize)
+	{
+		ACollisionQueryTestActor* Actor = World->SpawnActor<ACollisionQueryTestActor>(Start, FRotator::ZeroRotator);
+		Actor->Query = Query;
+		Actor->Shape = Shape;
+		Actor->Channel = ECC_WorldStatic;
+		Actor->BoxHalfExtent = FVector(ShapeSize);
+		Actor->SphereRadius = ShapeSize;
+		Actor->CapsuleRadius = ShapeSize;
+		Actor->CapsuleHalfHeight = ShapeSize * 2.f;
+		Actor->EndComponent->SetWorldLocation(End);
+		return Actor;
+	}
+}
+
+/**
+ * Builds a field of boxes, spheres or meshes at the density set by CollisionQueryTest.BenchmarkFieldCount and
+ * BenchmarkFieldSpacing, and benchmarks every single/multi/test, by and simple/complex combination of a line trace, and
+ * of sweeps and overlaps of each shape, through it. Fails if the average time of any exceeds its baseline by more than
+ * CollisionQueryTest.BenchmarkTolerance.
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FCollisionQueryBenchmarkQueriesTest, "CollisionQueryTest.Benchmark.Queries", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+void FCollisionQueryBenchmarkQueriesTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const TCHAR* FieldType : { TEXT("Boxes"), TEXT("Spheres"), TEXT("Meshes") })
+	{
+		OutBeautifiedNames.Add(FieldType);
+		OutTestCommands.Add(FieldType);
+	}
+}
+
+bool FCollisionQueryBenchmarkQueriesTest::RunTest(const FString& Parameters)
+{
+	using namespace CollisionQueryBenchmarkTests;
+
+	const int32 FieldCount = FMath::Max(CVarCollisionQueryTestBenchmarkFieldCount.GetValueOnGameThread(), 1);
+	const float FieldSpacing = FMath::Max(CVarCollisionQueryTestBenchmarkFieldSpacing.GetValueOnGameThread(), 1.f);
+	const int32 Iterations = FMath::Max(CVarCollisionQueryTestBenchmarkIterations.GetValueOnGameThread(), 1);
+	const double Tolerance = CVarCollisionQueryTestBenchmarkTolerance.GetValueOnGameThread();
+
+	UWorld* World = CreateWorld();
+	if (!BuildField(World, Parameters, FieldCount, FieldSpacing))
+	{
+		AddError(FString::Printf(TEXT("Failed to build a field of %s"), *Parameters));
+		DestroyWorld(World);
+		return false;
+	}
+
+	// queries cross the field diagonally, overlaps are made at its centre
+	const float HalfSize = FieldCount * FieldSpacing * 0.5f;
+	const FVector Start = FVector(-HalfSize, -HalfSize, -HalfSize * 0.5f);
+	const FVector End = FVector(HalfSize, HalfSize, HalfSize * 0.5f);
+	const float ShapeSize = FieldSpacing * 0.25f;
+
+	TArray<ACollisionQueryTestActor*> Actors;
+	Actors.Add(SpawnQueryActor(World, ECollisionQueryTestType::LineTrace, ECollisionQueryTestShape::Box, Start, End, ShapeSize));
+	for (const ECollisionQueryTestShape Shape : { ECollisionQueryTestShape::Box, ECollisionQueryTestShape::Sphere, ECollisionQueryTestShape::Capsule })
+	{
+		Actors.Add(SpawnQueryActor(World, ECollisionQueryTestType::Sweep, Shape, Start, End, ShapeSize));
+		Actors.Add(SpawnQueryActor(World, ECollisionQueryTestType::Overlap, Shape, FVector::ZeroVector, FVector::ZeroVector, FieldSpacing));
+	}
+
+	FBaselines Baselines;
+	TArray<FCollisionQueryTestDesc> Variants;
+	TArray<double> Samples;
+	FCollisionQueryTestResult Result;
+
+	for (const ACollisionQueryTestActor* Actor : Actors)
+	{
+		const FVector QueryStart = Actor->GetActorLocation();
+		const FVector QueryEnd = Actor->EndComponent->GetComponentLocation();
+		const FQuat Rot = Actor->GetActorQuat();
+
+		Variants.Reset();
+		Actor->MakeQueryDesc().GetVariants(Variants);
+
+		for (const FCollisionQueryTestDesc& Desc : Variants)
+		{
+			// warm up caches before measuring
+			Desc.Execute(World, QueryStart, QueryEnd, Rot, Result);
+
+			// a query which finds nothing measures an empty scene rather than the field
+			const bool bHitField = Result.bResult || Result.Hits.Num() > 0 || Result.Overlaps.Num() > 0;
+			TestTrue(FString::Printf(TEXT("%s finds the field"), *Desc.ToString()), bHitField);
+
+			Samples.Reset(Iterations);
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Desc.Execute(World, QueryStart, QueryEnd, Rot, Result);
+				Samples.Add(Result.ExecutionTime);
+			}
+
+			const FCollisionQueryLatencySummary Latency = FCollisionQueryLatencyHistory::Summarize(Samples);
+			Baselines.Check(*this, FString::Printf(TEXT("Queries.%s: %s"), *Parameters, *Desc.ToString()), Latency.Avg * 1e6, Tolerance, TEXT("us"));
+		}
+	}
+
+	Baselines.Save();
+	DestroyWorld(World);
+
+	return !HasAnyErrors();
+}
+
+/**
+ * Runs the phase breakdown of every line trace, sweep and overlap combination through a field of boxes. Fails if the
+ * broadphase reports fewer candidates than the full query hits, which it would if a blocking candidate cut it short.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCollisionQueryPhaseBreakdownTest, "CollisionQueryTest.PhaseBreakdown", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCollisionQueryPhaseBreakdownTest::RunTest(const FString& Parameters)
+{
+	using namespace CollisionQueryBenchmarkTests;
+
+	const int32 FieldCount = FMath::Max(CVarCollisionQueryTestBenchmarkFieldCount.GetValueOnGameThread(), 1);
+	const float FieldSpacing = FMath::Max(CVarCollisionQueryTestBenchmarkFieldSpacing.GetValueOnGameThread(), 1.f);
+
+	UWorld* World = CreateWorld();
+	if (!BuildField(World, TEXT("Boxes"), FieldCount, FieldSpacing))
+	{
+		AddError(TEXT("Failed to build a field of Boxes"));
+		DestroyWorld(World);
+		return false;
+	}
+
+	const float HalfSize = FieldCount * FieldSpacing * 0.5f;
+	const FVector Start = FVector(-HalfSize, -HalfSize, -HalfSize * 0.5f);
+	const FVector End = FVector(HalfSize, HalfSize, HalfSize * 0.5f);
+	const float ShapeSize = FieldSpacing * 0.25f;
+
+	TArray<ACollisionQueryTestActor*> Actors;
+	Actors.Add(SpawnQueryActor(World, ECollisionQueryTestType::LineTrace, ECollisionQueryTestShape::Box, Start, End, ShapeSize));
+	Actors.Add(SpawnQueryActor(World, ECollisionQueryTestType::Sweep, ECollisionQueryTestShape::Sphere, Start, End, ShapeSize));
+	Actors.Add(SpawnQueryActor(World, ECollisionQueryTestType::Overlap, ECollisionQueryTestShape::Box, FVector::ZeroVector, FVector::ZeroVector, FieldSpacing));
+
+	TArray<FCollisionQueryTestDesc> Variants;
+	FCollisionQueryPhaseBreakdown PhaseBreakdown;
+
+	for (const ACollisionQueryTestActor* Actor : Actors)
+	{
+		Variants.Reset();
+		Actor->MakeQueryDesc().GetVariants(Variants);
+
+		for (const FCollisionQueryTestDesc& Desc : Variants)
+		{
+			PhaseBreakdown.Run(World, Desc, Actor->GetActorLocation(), Actor->EndComponent->GetComponentLocation(), Actor->GetActorQuat());
+
+			const FString What = PhaseBreakdown.FullDesc.ToString();
+			TestTrue(FString::Printf(TEXT("%s hits the field"), *What), PhaseBreakdown.Hits.Num() > 0);
+			TestTrue(FString::Printf(TEXT("%s has at least as many broadphase candidates (%d) as hits (%d)"), *What, PhaseBreakdown.Candidates.Num(), PhaseBreakdown.Hits.Num()),
+				PhaseBreakdown.Candidates.Num() >= PhaseBreakdown.Hits.Num());
+		}
+	}
+
+	DestroyWorld(World);
+
+	return !HasAnyErrors();
+}
+
+#if ENABLE_DRAW_DEBUG
+
+/**
+ * Benchmarks each of the batched swept and static shape draw helpers. Fails if the number of lines one emits grows beyond
+ * its baseline, or its average time per call exceeds its baseline by more than CollisionQueryTest.BenchmarkTolerance.
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FCollisionQueryBenchmarkDrawTest, "CollisionQueryTest.Benchmark.Draw", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+void FCollisionQueryBenchmarkDrawTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const TCHAR* Helper : { TEXT("SweptBox"), TEXT("SweptSphere"), TEXT("SweptCapsule"), TEXT("Box"), TEXT("Sphere"), TEXT("Capsule") })
+	{
+		OutBeautifiedNames.Add(Helper);
+		OutTestCommands.Add(Helper);
+	}
+}
+
+bool FCollisionQueryBenchmarkDrawTest::RunTest(const FString& Parameters)
+{
+	using namespace CollisionQueryBenchmarkTests;
+
+	// draw helpers take well under a microsecond, so they are run many more times than the queries
+	const int32 Iterations = FMath::Max(CVarCollisionQueryTestBenchmarkIterations.GetValueOnGameThread(), 1) * 50;
+	const double Tolerance = CVarCollisionQueryTestBenchmarkTolerance.GetValueOnGameThread();
+
+	const FVector Start(0.f, 0.f, 0.f);
+	const FVector End(500.f, 200.f, 100.f);
+	const FQuat Rot(FRotator(10.f, 30.f, 0.f));
+
+	TFunction<void(TArray<FBatchedLine>&)> Draw;
+	if (Parameters == TEXT("SweptBox"))
+	{
+		Draw = [&](TArray<FBatchedLine>& Lines) { DrawDebugSweptBox(Lines, Start, End, Rot, FVector(25.f, 25.f, 50.f), FColor::Red); };
+	}
+	else if (Parameters == TEXT("SweptSphere"))
+	{
+		Draw = [&](TArray<FBatchedLine>& Lines) { DrawDebugSweptSphere(Lines, Start, End, 40.f, FColor::Red); };
+	}
+	else if (Parameters == TEXT("SweptCapsule"))
+	{
+		Draw = [&](TArray<FBatchedLine>& Lines) { DrawDebugSweptCapsule(Lines, Start, End, Rot, 80.f, 40.f, FColor::Red); };
+	}
+	else if (Parameters == TEXT("Box"))
+	{
+		Draw = [&](TArray<FBatchedLine>& Lines) { DrawDebugCollisionShape(Lines, Start, Rot, FCollisionShape::MakeBox(FVector(25.f, 25.f, 50.f)), FColor::Red); };
+	}
+	else if (Parameters == TEXT("Sphere"))
+	{
+		Draw = [&](TArray<FBatchedLine>& Lines) { DrawDebugCollisionShape(Lines, Start, Rot, FCollisionShape::MakeSphere(40.f), FColor::Red); };
+	}
+	else if (Parameters == TEXT("Capsule"))
+	{
+		Draw = [&](TArray<FBatchedLine>& Lines) { DrawDebugCollisionShape(Lines, Start, Rot, FCollisionShape::MakeCapsule(40.f, 80.f), FColor::Red); };
+	}
+	else
+	{
+		AddError(FString::Printf(TEXT("Unknown draw helper %s"), *Parameters));
+		return false;
+	}
+
+	TArray<FBatchedLine> Lines;
+
+	// warm up caches and grow the array before measuring
+	Draw(Lines);
+	const int32 NumLines = Lines.Num();
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		Lines.Reset();
+		Draw(Lines);
+	}
+	const double TimePerCall = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / Iterations;
+
+	FBaselines Baselines;
+	Baselines.Check(*this, FString::Printf(TEXT("Draw.%s: Lines"), *Parameters), NumLines, 0.0, TEXT(""));
+	Baselines.Check(*this, FString::Printf(TEXT("Draw.%s: Time"), *Parameters), TimePerCall * 1e6, Tolerance, TEXT("us"));
+	Baselines.Save();
+
+	return !HasAnyErrors();
+}
+
+#endif // ENABLE_DRAW_DEBUG
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,226 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryCapture.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryCapture.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCollisionQueryCapture, Log, All);
+
+static FAutoConsoleCommand CollisionQueryTestCaptureCommand(
+	TEXT("CollisionQueryTest.Capture"),
+	TEXT("Capture every query reported by test actors or FCollisionQueryCaptureScope for a number of frames, then log them totalled by trace tag and call. Usage: CollisionQueryTest.Capture [NumFrames=60, 0 to capture until CollisionQueryTest.StopCapture]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumFrames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 60;
+		FCollisionQueryCapture::Get().Begin(FMath::Max(NumFrames, 0));
+	}));
+
+static FAutoConsoleCommand CollisionQueryTestStopCaptureCommand(
+	TEXT("CollisionQueryTest.StopCapture"),
+	TEXT("Stop the running query capture and log its report."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FCollisionQueryCapture::Get().End();
+	}));
+
+const TCHAR* LexToString(ECollisionQueryCaptureCall Call)
+{
+	switch (Call)
+	{
+	case ECollisionQueryCaptureCall::LineTraceTest:			return TEXT("LineTraceTest");
+	case ECollisionQueryCaptureCall::LineTraceSingle:		return TEXT("LineTraceSingle");
+	case ECollisionQueryCaptureCall::LineTraceMulti:		return TEXT("LineTraceMulti");
+	case ECollisionQueryCaptureCall::SweepTest:				return TEXT("SweepTest");
+	case ECollisionQueryCaptureCall::SweepSingle:			return TEXT("SweepSingle");
+	case ECollisionQueryCaptureCall::SweepMulti:			return TEXT("SweepMulti");
+	case ECollisionQueryCaptureCall::OverlapBlockingTest:	return TEXT("OverlapBlockingTest");
+	case ECollisionQueryCaptureCall::OverlapAnyTest:		return TEXT("OverlapAnyTest");
+	case ECollisionQueryCaptureCall::OverlapMulti:			return TEXT("OverlapMulti");
+	default:												return TEXT("Unknown");
+	}
+}
+
+void FCollisionQueryCaptureTotals::Add(double QueryTime, bool bHit)
+{
+	++NumQueries;
+	NumHits += bHit ? 1 : 0;
+	Time += QueryTime;
+}
+
+void FCollisionQueryCaptureReport::Log() const
+{
+	const double TimePerFrame = NumFrames > 0 ? Total.Time / NumFrames : 0.0;
+	UE_LOG(LogCollisionQueryCapture, Display, TEXT("Captured %d queries over %d frames: %.3fms total, %.1fus per frame, %.0f%% hit, %d dropped"),
+		Total.NumQueries, NumFrames, Total.Time * 1e3, TimePerFrame * 1e6, Total.GetHitRate() * 100.0, NumDropped);
+
+	auto LogTotals = [this](const FString& Name, const FCollisionQueryCaptureTotals& Totals)
+	{
+		const double Share = Total.Time > 0.0 ? Totals.Time / Total.Time : 0.0;
+		const double Avg = Totals.NumQueries > 0 ? Totals.Time / Totals.NumQueries : 0.0;
+		UE_LOG(LogCollisionQueryCapture, Display, TEXT("  %-48s %8d queries %10.3fms %5.1f%% %8.2fus avg %5.0f%% hit"),
+			*Name, Totals.NumQueries, Totals.Time * 1e3, Share * 100.0, Avg * 1e6, Totals.GetHitRate() * 100.0);
+	};
+
+	TArray<TPair<FName, FName>> Tags;
+	ByTag.GetKeys(Tags);
+	Tags.Sort([this](const TPair<FName, FName>& A, const TPair<FName, FName>& B) { return ByTag[A].Time > ByTag[B].Time; });
+
+	UE_LOG(LogCollisionQueryCapture, Display, TEXT("By TraceTag / OwnerTag:"));
+	for (const TPair<FName, FName>& Tag : Tags)
+	{
+		LogTotals(FString::Printf(TEXT("%s / %s"), *Tag.Key.ToString(), *Tag.Value.ToString()), ByTag[Tag]);
+	}
+
+	TArray<int32> Calls;
+	for (int32 CallIdx = 0; CallIdx < UE_ARRAY_COUNT(ByCall); ++CallIdx)
+	{
+		if (ByCall[CallIdx].NumQueries > 0)
+		{
+			Calls.Add(CallIdx);
+		}
+	}
+	Calls.Sort([this](int32 A, int32 B) { return ByCall[A].Time > ByCall[B].Time; });
+
+	UE_LOG(LogCollisionQueryCapture, Display, TEXT("By call:"));
+	for (const int32 CallIdx : Calls)
+	{
+		LogTotals(LexToString(static_cast<ECollisionQueryCaptureCall>(CallIdx)), ByCall[CallIdx]);
+	}
+}
+
+FCollisionQueryCapture& FCollisionQueryCapture::Get()
+{
+	static FCollisionQueryCapture Capture;
+	return Capture;
+}
+
+FCollisionQueryCapture::~FCollisionQueryCapture()
+{
+	// the core ticker may already be gone on exit, so only stop capturing
+	bCapturing = false;
+}
+
+void FCollisionQueryCapture::Begin(int32 NumFrames)
+{
+	check(IsInGameThread());
+
+	if (IsCapturing())
+	{
+		End();
+	}
+
+	// discard anything reported after the last capture ended
+	Drain(true);
+
+	Report = FCollisionQueryCaptureReport();
+	FramesToCapture = NumFrames;
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FCollisionQueryCapture::Tick));
+	bCapturing = true;
+
+	UE_LOG(LogCollisionQueryCapture, Display, TEXT("Capturing queries for %d frames"), NumFrames);
+}
+
+void FCollisionQueryCapture::End()
+{
+	check(IsInGameThread());
+
+	if (!IsCapturing())
+	{
+		return;
+	}
+
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	TickHandle.Reset();
+
+	bCapturing = false;
+	Drain(false);
+	Report.Log();
+}
+
+bool FCollisionQueryCapture::Tick(float DeltaTime)
+{
+	Drain(false);
+	++Report.NumFrames;
+
+	if (FramesToCapture > 0 && Report.NumFrames >= FramesToCapture)
+	{
+		bCapturing = false;
+		Drain(false);
+		Report.Log();
+
+		TickHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FCollisionQueryCapture::RecordInternal(ECollisionQueryCaptureCall Call, const FCollisionQueryParams& Params, double Time, bool bHit)
+{
+	FThreadBuffer& Buffer = GetThreadBuffer();
+
+	const uint32 Head = Buffer.Head.load(std::memory_order_relaxed);
+	if (Head - Buffer.Tail.load(std::memory_order_acquire) >= FThreadBuffer::Capacity)
+	{
+		Buffer.NumDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	FEntry& Entry = Buffer.Entries[Head & (FThreadBuffer::Capacity - 1)];
+	Entry.TraceTag = Params.TraceTag;
+	Entry.OwnerTag = Params.OwnerTag;
+	Entry.Time = Time;
+	Entry.Call = Call;
+	Entry.bHit = bHit;
+
+	Buffer.Head.store(Head + 1, std::memory_order_release);
+}
+
+FCollisionQueryCapture::FThreadBuffer& FCollisionQueryCapture::GetThreadBuffer()
+{
+	// buffers are kept until exit, as the thread local pointer cannot be cleared from another thread
+	static thread_local FThreadBuffer* ThreadBuffer = nullptr;
+	if (!ThreadBuffer)
+	{
+		FScopeLock Lock(&ThreadBuffersLock);
+		ThreadBuffer = ThreadBuffers.Add_GetRef(MakeUnique<FThreadBuffer>()).Get();
+	}
+	return *ThreadBuffer;
+}
+
+void FCollisionQueryCapture::Drain(bool bDiscard)
+{
+	FScopeLock Lock(&ThreadBuffersLock);
+
+	for (const TUniquePtr<FThreadBuffer>& Buffer : ThreadBuffers)
+	{
+		const uint32 Head = Buffer->Head.load(std::memory_order_acquire);
+		uint32 Tail = Buffer->Tail.load(std::memory_order_relaxed);
+
+		if (!bDiscard)
+		{
+			for (; Tail != Head; ++Tail)
+			{
+				const FEntry& Entry = Buffer->Entries[Tail & (FThreadBuffer::Capacity - 1)];
+				Report.Total.Add(Entry.Time, Entry.bHit);
+				Report.ByTag.FindOrAdd(TPair<FName, FName>(Entry.TraceTag, Entry.OwnerTag)).Add(Entry.Time, Entry.bHit);
+				Report.ByCall[static_cast<int32>(Entry.Call)].Add(Entry.Time, Entry.bHit);
+			}
+		}
+
+		Buffer->Tail.store(Head, std::memory_order_release);
+
+		const uint32 NumDropped = Buffer->NumDropped.exchange(0, std::memory_order_relaxed);
+		if (!bDiscard)
+		{
+			Report.NumDropped += NumDropped;
+		}
+	}
+}
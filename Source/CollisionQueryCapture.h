@@ -0,0 +1,175 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryCapture.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Containers/Ticker.h"
+#include "HAL/CriticalSection.h"
+
+#include <atomic>
+
+/**
+ * The scene query function a captured query was made with.
+ */
+enum class ECollisionQueryCaptureCall : uint8
+{
+	LineTraceTest,
+	LineTraceSingle,
+	LineTraceMulti,
+	SweepTest,
+	SweepSingle,
+	SweepMulti,
+	OverlapBlockingTest,
+	OverlapAnyTest,
+	OverlapMulti,
+
+	Num
+};
+
+const TCHAR* LexToString(ECollisionQueryCaptureCall Call);
+
+/**
+ * Totals of a set of captured queries.
+ */
+struct FCollisionQueryCaptureTotals
+{
+	int32 NumQueries = 0;
+	int32 NumHits = 0;
+	double Time = 0.0; // seconds
+
+	void Add(double QueryTime, bool bHit);
+	double GetHitRate() const { return NumQueries > 0 ? static_cast<double>(NumHits) / NumQueries : 0.0; }
+};
+
+/**
+ * The queries of a capture, totalled by trace tag / owner tag pair and by call.
+ */
+struct FCollisionQueryCaptureReport
+{
+	int32 NumFrames = 0;
+	int32 NumDropped = 0;
+
+	FCollisionQueryCaptureTotals Total;
+	TMap<TPair<FName, FName>, FCollisionQueryCaptureTotals> ByTag;
+	FCollisionQueryCaptureTotals ByCall[static_cast<int32>(ECollisionQueryCaptureCall::Num)];
+
+	/** Logs the report, with the tags and calls which took the most time first. */
+	void Log() const;
+};
+
+/**
+ * Captures the queries reported to it over a window of frames and totals them by FCollisionQueryParams::TraceTag and
+ * OwnerTag and by call, to find which systems spend the collision budget. Queries made by test actors are reported
+ * automatically, and queries made anywhere else can be included by wrapping them in a FCollisionQueryCaptureScope.
+ *
+ * Reporting a query is lock free: each thread writes to its own ring buffer, and the buffers are drained on the game
+ * thread every frame. Queries reported while a thread's buffer is full are dropped and counted in the report.
+ */
+class FCollisionQueryCapture
+{
+public:
+	static FCollisionQueryCapture& Get();
+
+	~FCollisionQueryCapture();
+
+	/** Starts capturing. The report is logged after NumFrames frames, or when End is called if NumFrames is zero. Game thread only. */
+	void Begin(int32 NumFrames);
+
+	/** Stops capturing and logs the report. Game thread only. */
+	void End();
+
+	bool IsCapturing() const { return bCapturing.load(std::memory_order_relaxed); }
+
+	/** The report of the current capture, or of the last one if none is running. */
+	const FCollisionQueryCaptureReport& GetReport() const { return Report; }
+
+	/** Reports a completed query. Does nothing unless a capture is running. Thread safe. */
+	static void Record(ECollisionQueryCaptureCall Call, const FCollisionQueryParams& Params, double Time, bool bHit)
+	{
+		FCollisionQueryCapture& Capture = Get();
+		if (Capture.IsCapturing())
+		{
+			Capture.RecordInternal(Call, Params, Time, bHit);
+		}
+	}
+
+private:
+	struct FEntry
+	{
+		FName TraceTag;
+		FName OwnerTag;
+		double Time = 0.0;
+		ECollisionQueryCaptureCall Call = ECollisionQueryCaptureCall::LineTraceTest;
+		bool bHit = false;
+	};
+
+	/** Single producer, single consumer ring buffer. Written by the thread which owns it, read by the game thread. */
+	struct FThreadBuffer
+	{
+		static constexpr uint32 Capacity = 4096; // must be a power of two
+
+		FThreadBuffer() { Entries.SetNum(Capacity); }
+
+		TArray<FEntry> Entries;
+		std::atomic<uint32> Head { 0 };
+		std::atomic<uint32> Tail { 0 };
+		std::atomic<uint32> NumDropped { 0 };
+	};
+
+	void RecordInternal(ECollisionQueryCaptureCall Call, const FCollisionQueryParams& Params, double Time, bool bHit);
+	FThreadBuffer& GetThreadBuffer();
+
+	/** Adds the entries waiting in every thread's buffer to the report, or discards them. */
+	void Drain(bool bDiscard);
+
+	bool Tick(float DeltaTime);
+
+	std::atomic<bool> bCapturing { false };
+	int32 FramesToCapture = 0;
+	FCollisionQueryCaptureReport Report;
+	FTSTicker::FDelegateHandle TickHandle;
+
+	/** Buffers of every thread which has reported a query. Only locked when a thread reports its first query, and to drain. */
+	TArray<TUniquePtr<FThreadBuffer>> ThreadBuffers;
+	FCriticalSection ThreadBuffersLock;
+};
+
+/**
+ * Times the query made within its scope and reports it to any running capture, eg.
+ *
+ *	FCollisionQueryCaptureScope CaptureScope(ECollisionQueryCaptureCall::LineTraceSingle, Params);
+ *	CaptureScope.bHit = World->LineTraceSingleByChannel(Hit, Start, End, Channel, Params);
+ */
+class FCollisionQueryCaptureScope
+{
+public:
+	FCollisionQueryCaptureScope(ECollisionQueryCaptureCall InCall, const FCollisionQueryParams& InParams)
+		: Params(InParams)
+		, Call(InCall)
+		, StartCycles(FCollisionQueryCapture::Get().IsCapturing() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FCollisionQueryCaptureScope()
+	{
+		if (StartCycles != 0)
+		{
+			FCollisionQueryCapture::Record(Call, Params, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), bHit);
+		}
+	}
+
+	bool bHit = false;
+
+private:
+	const FCollisionQueryParams& Params;
+	ECollisionQueryCaptureCall Call;
+	uint64 StartCycles;
+};
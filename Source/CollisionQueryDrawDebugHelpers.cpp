@@ -8,113 +8,615 @@
 // Author		-> George Prosser (Studio Gobo)
 
 #include "CollisionQueryDrawDebugHelpers.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/GameViewportClient.h"
+#include "SceneView.h"
+#include "HAL/IConsoleManager.h"
 
 #if ENABLE_DRAW_DEBUG
 
-void DrawDebugSweptBox(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FVector& HalfSize, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+static TAutoConsoleVariable<bool> CVarCollisionQueryTestDrawLOD(
+	TEXT("CollisionQueryTest.DrawLOD"),
+	true,
+	TEXT("Cull debug shapes outside the view and reduce their detail with screen size, in the debug draw helpers which take a FCollisionQueryDebugDrawView."));
+
+static TAutoConsoleVariable<float> CVarCollisionQueryTestDrawLODFallbackDistance(
+	TEXT("CollisionQueryTest.DrawLODFallbackDistance"),
+	10000.f,
+	TEXT("Distance from the view beyond which debug shapes are drawn as a single line or marker. 0 for no limit."));
+
+namespace CollisionQueryDrawDebug
 {
-	DrawDebugBox(World, Start, HalfSize, Rotation, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawDebugBox(World, End, HalfSize, Rotation, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+	// number of segments used for circles, matching DrawDebugCapsule
+	static constexpr int32 NumCircleSegments = 16;
 
-	FVector Vertices[8];
-	Vertices[0] = Start + Rotation.RotateVector(FVector(-HalfSize.X, -HalfSize.Y, -HalfSize.Z));
-	Vertices[1] = Start + Rotation.RotateVector(FVector(-HalfSize.X, HalfSize.Y, -HalfSize.Z));
-	Vertices[2] = Start + Rotation.RotateVector(FVector(-HalfSize.X, -HalfSize.Y, HalfSize.Z));
-	Vertices[3] = Start + Rotation.RotateVector(FVector(-HalfSize.X, HalfSize.Y, HalfSize.Z));
-	Vertices[4] = Start + Rotation.RotateVector(FVector(HalfSize.X, -HalfSize.Y, -HalfSize.Z));
-	Vertices[5] = Start + Rotation.RotateVector(FVector(HalfSize.X, HalfSize.Y, -HalfSize.Z));
-	Vertices[6] = Start + Rotation.RotateVector(FVector(HalfSize.X, -HalfSize.Y, HalfSize.Z));
-	Vertices[7] = Start + Rotation.RotateVector(FVector(HalfSize.X, HalfSize.Y, HalfSize.Z));
+	// scratch array used by the non-batched helpers, so that drawing a shape does not allocate
+	static TArray<FBatchedLine>& GetScratchLines()
+	{
+		check(IsInGameThread());
+		static TArray<FBatchedLine> ScratchLines;
+		return ScratchLines;
+	}
 
-	const FVector TraceVec = End - Start;
-	for (int32 VertexIdx = 0; VertexIdx < 8; ++VertexIdx)
+	struct FUnitVertex
+	{
+		float X = 0.f;
+		float Y = 0.f;
+		float Z = 0.f;
+	};
+
+	// FMath::Sin and FMath::Cos are not constexpr, so the tables below are built with a Taylor series instead
+	constexpr double ConstexprSin(double X)
+	{
+		while (X > UE_DOUBLE_PI)
+		{
+			X -= UE_DOUBLE_TWO_PI;
+		}
+		while (X < -UE_DOUBLE_PI)
+		{
+			X += UE_DOUBLE_TWO_PI;
+		}
+
+		double Term = X;
+		double Sum = X;
+		for (int32 N = 1; N < 12; ++N)
+		{
+			Term *= -X * X / ((2 * N) * (2 * N + 1));
+			Sum += Term;
+		}
+		return Sum;
+	}
+
+	constexpr double ConstexprCos(double X)
+	{
+		return ConstexprSin(X + UE_DOUBLE_HALF_PI);
+	}
+
+	/**
+	 * Unit radius capsule cap (or sphere) wireframe: a ring around Z, then half circle arcs over the top in the YZ and XZ
+	 * planes. The first half of the ring doubles as a half circle. A cap is drawn by transforming the whole set at once.
+	 */
+	template<int32 NumSegments>
+	struct TUnitCapsuleCap
+	{
+		static_assert(NumSegments >= 4 && NumSegments % 2 == 0, "Capsule caps need an even number of segments");
+
+		static constexpr int32 NumRingVertices = NumSegments + 1; // the first vertex is repeated to close the ring
+		static constexpr int32 NumArcVertices = NumSegments / 2 + 1;
+		static constexpr int32 RingStart = 0;
+		static constexpr int32 YZArcStart = NumRingVertices;
+		static constexpr int32 XZArcStart = NumRingVertices + NumArcVertices;
+		static constexpr int32 NumVertices = NumRingVertices + 2 * NumArcVertices;
+
+		FUnitVertex Vertices[NumVertices] = {};
+
+		constexpr TUnitCapsuleCap()
+		{
+			for (int32 Idx = 0; Idx < NumRingVertices; ++Idx)
+			{
+				const double Angle = UE_DOUBLE_TWO_PI * Idx / NumSegments;
+				Vertices[RingStart + Idx] = { (float)ConstexprCos(Angle), (float)ConstexprSin(Angle), 0.f };
+			}
+
+			for (int32 Idx = 0; Idx < NumArcVertices; ++Idx)
+			{
+				const double Angle = UE_DOUBLE_TWO_PI * Idx / NumSegments;
+				Vertices[YZArcStart + Idx] = { 0.f, (float)ConstexprCos(Angle), (float)ConstexprSin(Angle) };
+				Vertices[XZArcStart + Idx] = { (float)ConstexprCos(Angle), 0.f, (float)ConstexprSin(Angle) };
+			}
+		}
+	};
+
+	template<int32 NumSegments>
+	inline constexpr TUnitCapsuleCap<NumSegments> UnitCapsuleCap = TUnitCapsuleCap<NumSegments>();
+
+	// corners of a unit box, indexed so that X, Y and Z are bits 2, 0 and 1. Each edge joins two corners whose indices differ by one bit.
+	inline constexpr FUnitVertex UnitBoxCorners[8] =
+	{
+		{ -1.f, -1.f, -1.f }, { -1.f, 1.f, -1.f }, { -1.f, -1.f, 1.f }, { -1.f, 1.f, 1.f },
+		{ 1.f, -1.f, -1.f }, { 1.f, 1.f, -1.f }, { 1.f, -1.f, 1.f }, { 1.f, 1.f, 1.f }
+	};
+
+	/** Transforms each unit vertex V to Origin + V.X * AxisX + V.Y * AxisY + V.Z * AxisZ. The axes carry the rotation and scale. */
+	static void TransformVertices(const FUnitVertex* InVertices, int32 NumVertices, const FVector& AxisX, const FVector& AxisY, const FVector& AxisZ, const FVector& Origin, FVector* OutVertices)
+	{
+		const VectorRegister4Double X = VectorLoadFloat3_W0(&AxisX.X);
+		const VectorRegister4Double Y = VectorLoadFloat3_W0(&AxisY.X);
+		const VectorRegister4Double Z = VectorLoadFloat3_W0(&AxisZ.X);
+		const VectorRegister4Double O = VectorLoadFloat3_W0(&Origin.X);
+
+		for (int32 VertexIdx = 0; VertexIdx < NumVertices; ++VertexIdx)
+		{
+			const FUnitVertex& In = InVertices[VertexIdx];
+			VectorRegister4Double Result = VectorMultiplyAdd(VectorSetFloat1((double)In.X), X, O);
+			Result = VectorMultiplyAdd(VectorSetFloat1((double)In.Y), Y, Result);
+			Result = VectorMultiplyAdd(VectorSetFloat1((double)In.Z), Z, Result);
+			VectorStoreFloat3(Result, &OutVertices[VertexIdx].X);
+		}
+	}
+
+	static void AddLineStrip(TArray<FBatchedLine>& OutLines, const FVector* Vertices, int32 NumVertices, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		for (int32 VertexIdx = 1; VertexIdx < NumVertices; ++VertexIdx)
+		{
+			OutLines.Emplace(Vertices[VertexIdx - 1], Vertices[VertexIdx], Color, 0.f, Thickness, DepthPriority);
+		}
+	}
+
+	/** Adds a circle around Base in the plane of X and Y. */
+	template<int32 NumSegments>
+	static void AddCircle(TArray<FBatchedLine>& OutLines, const FVector& Base, const FVector& X, const FVector& Y, float Radius, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		using FCap = TUnitCapsuleCap<NumSegments>;
+
+		FVector Vertices[FCap::NumRingVertices];
+		TransformVertices(UnitCapsuleCap<NumSegments>.Vertices + FCap::RingStart, FCap::NumRingVertices, X * Radius, Y * Radius, FVector::ZeroVector, Base, Vertices);
+		AddLineStrip(OutLines, Vertices, FCap::NumRingVertices, Color, DepthPriority, Thickness);
+	}
+
+	static void AddBox(TArray<FBatchedLine>& OutLines, const FVector* Vertices, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		for (int32 VertexIdx = 0; VertexIdx < 8; ++VertexIdx)
+		{
+			for (int32 Bit = 1; Bit < 8; Bit <<= 1)
+			{
+				if ((VertexIdx & Bit) == 0)
+				{
+					OutLines.Emplace(Vertices[VertexIdx], Vertices[VertexIdx | Bit], Color, 0.f, Thickness, DepthPriority);
+				}
+			}
+		}
+	}
+
+	static void TransformBox(const FVector& Center, const FVector& HalfSize, const FQuat& Rotation, FVector* OutVertices)
+	{
+		TransformVertices(UnitBoxCorners, 8, Rotation.GetAxisX() * HalfSize.X, Rotation.GetAxisY() * HalfSize.Y, Rotation.GetAxisZ() * HalfSize.Z, Center, OutVertices);
+	}
+
+	/** Adds a capsule cap, centred on Base with its dome pointing along Z. The ring lies in the plane of X and Y. */
+	template<int32 NumSegments>
+	static void AddCapsuleCap(TArray<FBatchedLine>& OutLines, const FVector& Base, const FVector& X, const FVector& Y, const FVector& Z, float Radius, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		using FCap = TUnitCapsuleCap<NumSegments>;
+
+		FVector Vertices[FCap::NumVertices];
+		TransformVertices(UnitCapsuleCap<NumSegments>.Vertices, FCap::NumVertices, X * Radius, Y * Radius, Z * Radius, Base, Vertices);
+
+		AddLineStrip(OutLines, Vertices + FCap::RingStart, FCap::NumRingVertices, Color, DepthPriority, Thickness);
+		AddLineStrip(OutLines, Vertices + FCap::YZArcStart, FCap::NumArcVertices, Color, DepthPriority, Thickness);
+		AddLineStrip(OutLines, Vertices + FCap::XZArcStart, FCap::NumArcVertices, Color, DepthPriority, Thickness);
+	}
+
+	template<int32 NumSegments>
+	static void AddCapsule(TArray<FBatchedLine>& OutLines, const FVector& Center, float HalfHeight, float Radius, const FQuat& Rotation, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		// matches the wireframe drawn by DrawDebugCapsule
+		const FVector XAxis = Rotation.GetAxisX();
+		const FVector YAxis = Rotation.GetAxisY();
+		const FVector ZAxis = Rotation.GetAxisZ();
+
+		const float HalfAxis = FMath::Max(HalfHeight - Radius, 1.f);
+		const FVector TopEnd = Center + HalfAxis * ZAxis;
+		const FVector BottomEnd = Center - HalfAxis * ZAxis;
+
+		AddCapsuleCap<NumSegments>(OutLines, TopEnd, XAxis, YAxis, ZAxis, Radius, Color, DepthPriority, Thickness);
+		AddCapsuleCap<NumSegments>(OutLines, BottomEnd, XAxis, YAxis, -ZAxis, Radius, Color, DepthPriority, Thickness);
+
+		OutLines.Emplace(TopEnd + Radius * XAxis, BottomEnd + Radius * XAxis, Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(TopEnd - Radius * XAxis, BottomEnd - Radius * XAxis, Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(TopEnd + Radius * YAxis, BottomEnd + Radius * YAxis, Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(TopEnd - Radius * YAxis, BottomEnd - Radius * YAxis, Color, 0.f, Thickness, DepthPriority);
+	}
+
+	template<int32 NumSegments>
+	static void AddSweptSphere(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, float Radius, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		const FVector TraceVec = End - Start;
+		const float Dist = TraceVec.Size();
+
+		OutLines.Reserve(OutLines.Num() + (4 * NumSegments + 4) + 4 * NumSegments);
+
+		// draw the sweep of the sphere as a capsule
+		const FVector Center = Start + TraceVec * 0.5f;
+		const float CapsuleHalfHeight = (Dist * 0.5f) + Radius;
+		const FQuat CapsuleRot = FRotationMatrix::MakeFromZ(TraceVec).ToQuat();
+		AddCapsule<NumSegments>(OutLines, Center, CapsuleHalfHeight, Radius, CapsuleRot, Color, DepthPriority, Thickness);
+
+		// draw additional circles for the spheres at each end of the capsule
+		AddCircle<NumSegments>(OutLines, Start, CapsuleRot.GetAxisY(), CapsuleRot.GetAxisZ(), Radius, Color, DepthPriority, Thickness);
+		AddCircle<NumSegments>(OutLines, Start, CapsuleRot.GetAxisX(), CapsuleRot.GetAxisZ(), Radius, Color, DepthPriority, Thickness);
+		AddCircle<NumSegments>(OutLines, End, CapsuleRot.GetAxisY(), -CapsuleRot.GetAxisZ(), Radius, Color, DepthPriority, Thickness);
+		AddCircle<NumSegments>(OutLines, End, CapsuleRot.GetAxisX(), -CapsuleRot.GetAxisZ(), Radius, Color, DepthPriority, Thickness);
+	}
+
+	template<int32 NumSegments>
+	static void AddSweptCapsule(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FQuat& Rotation, float HalfHeight, float Radius, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		OutLines.Reserve(OutLines.Num() + 2 * (4 * NumSegments + 4) + 6);
+
+		AddCapsule<NumSegments>(OutLines, Start, HalfHeight, Radius, Rotation, Color, DepthPriority, Thickness);
+		AddCapsule<NumSegments>(OutLines, End, HalfHeight, Radius, Rotation, Color, DepthPriority, Thickness);
+
+		const FVector Up = Rotation.GetUpVector();
+
+		const FMatrix Mat = FRotationMatrix::MakeFromZX(End - Start, Up);
+		const FVector YAxis = Mat.GetUnitAxis(EAxis::Y);
+		const FVector XAxis =  Mat.GetUnitAxis(EAxis::X);
+
+		const float HalfLength = HalfHeight - Radius;
+		const FVector StartTop = Start + HalfLength*Up;
+		const FVector EndTop = End + HalfLength*Up;
+
+		OutLines.Emplace(StartTop + Radius*XAxis, EndTop + Radius*XAxis, Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(StartTop + Radius*YAxis, EndTop + Radius*YAxis, Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(StartTop - Radius*YAxis, EndTop - Radius*YAxis, Color, 0.f, Thickness, DepthPriority);
+
+		const FVector StartBottom = Start - HalfLength*Up;
+		const FVector EndBottom = End - HalfLength*Up;
+
+		OutLines.Emplace(StartBottom - Radius*XAxis, EndBottom - Radius*XAxis, Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(StartBottom + Radius*YAxis, EndBottom + Radius*YAxis, Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(StartBottom - Radius*YAxis, EndBottom - Radius*YAxis, Color, 0.f, Thickness, DepthPriority);
+	}
+
+	template<int32 NumSegments>
+	static void AddSphere(TArray<FBatchedLine>& OutLines, const FVector& Center, const FQuat& Rotation, float Radius, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		AddCircle<NumSegments>(OutLines, Center, Rotation.GetAxisX(), Rotation.GetAxisY(), Radius, Color, DepthPriority, Thickness);
+		AddCircle<NumSegments>(OutLines, Center, Rotation.GetAxisX(), Rotation.GetAxisZ(), Radius, Color, DepthPriority, Thickness);
+	}
+
+	/** Calls Functor with a TIntegralConstant of the number of segments, so that it can pick the matching vertex table. */
+	template<typename FunctorType>
+	static void DispatchNumSegments(int32 NumSegments, FunctorType&& Functor)
 	{
-		DrawDebugLine(World, Vertices[VertexIdx], Vertices[VertexIdx] + TraceVec, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+		switch (NumSegments)
+		{
+		case 4:		Functor(TIntegralConstant<int32, 4>()); break;
+		case 8:		Functor(TIntegralConstant<int32, 8>()); break;
+		case 32:	Functor(TIntegralConstant<int32, 32>()); break;
+		default:	Functor(TIntegralConstant<int32, 16>()); break;
+		}
 	}
+
+	/** Marker drawn in place of a shape too small or far away to make out: three axis lines across its extent. */
+	static void AddMarker(TArray<FBatchedLine>& OutLines, const FVector& Center, float Extent, const FLinearColor& Color, uint8 DepthPriority, float Thickness)
+	{
+		OutLines.Emplace(Center - FVector(Extent, 0.f, 0.f), Center + FVector(Extent, 0.f, 0.f), Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(Center - FVector(0.f, Extent, 0.f), Center + FVector(0.f, Extent, 0.f), Color, 0.f, Thickness, DepthPriority);
+		OutLines.Emplace(Center - FVector(0.f, 0.f, Extent), Center + FVector(0.f, 0.f, Extent), Color, 0.f, Thickness, DepthPriority);
+	}
+}
+
+void DrawDebugSweptBox(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FVector& HalfSize, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+{
+	TArray<FBatchedLine>& Lines = CollisionQueryDrawDebug::GetScratchLines();
+	DrawDebugSweptBox(Lines, Start, End, Rotation, HalfSize, Color, DepthPriority, Thickness);
+	DrawDebugBatchedLines(World, Lines, bPersistentLines, LifeTime, DepthPriority);
 }
 
 void DrawDebugSweptSphere(const UWorld* World, const FVector& Start, const FVector& End, float Radius, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
 {
-	const FVector TraceVec = End - Start;
-	const float Dist = TraceVec.Size();
+	TArray<FBatchedLine>& Lines = CollisionQueryDrawDebug::GetScratchLines();
+	DrawDebugSweptSphere(Lines, Start, End, Radius, Color, DepthPriority, Thickness);
+	DrawDebugBatchedLines(World, Lines, bPersistentLines, LifeTime, DepthPriority);
+}
 
-	// draw the sweep of the sphere as a capsule
-	const FVector Center = Start + TraceVec * 0.5f;
-	const float CapsuleHalfHeight = (Dist * 0.5f) + Radius;
-	const FQuat CapsuleRot = FRotationMatrix::MakeFromZ(TraceVec).ToQuat();
-	DrawDebugCapsule(World, Center, CapsuleHalfHeight, Radius, CapsuleRot, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+void DrawDebugSweptCapsule(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, float HalfHeight, float Radius, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+{
+	TArray<FBatchedLine>& Lines = CollisionQueryDrawDebug::GetScratchLines();
+	DrawDebugSweptCapsule(Lines, Start, End, Rotation, HalfHeight, Radius, Color, DepthPriority, Thickness);
+	DrawDebugBatchedLines(World, Lines, bPersistentLines, LifeTime, DepthPriority);
+}
 
-	// draw additional circles for the spheres at each end of the capsule
-	DrawCircle(World, Start, CapsuleRot.GetAxisY(), CapsuleRot.GetAxisZ(), Color, Radius, 16, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawCircle(World, Start, CapsuleRot.GetAxisX(), CapsuleRot.GetAxisZ(), Color, Radius, 16, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawCircle(World, End, CapsuleRot.GetAxisY(), -CapsuleRot.GetAxisZ(), Color, Radius, 16, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawCircle(World, End, CapsuleRot.GetAxisX(), -CapsuleRot.GetAxisZ(), Color, Radius, 16, bPersistentLines, LifeTime, DepthPriority, Thickness);
+void DrawDebugSweptCollisionShape(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+{
+	TArray<FBatchedLine>& Lines = CollisionQueryDrawDebug::GetScratchLines();
+	DrawDebugSweptCollisionShape(Lines, Start, End, Rotation, Shape, Color, DepthPriority, Thickness);
+	DrawDebugBatchedLines(World, Lines, bPersistentLines, LifeTime, DepthPriority);
 }
 
-void DrawDebugSweptCapsule(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, float HalfHeight, float Radius, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+void DrawDebugCollisionShape(const UWorld* World, const FVector& Pos, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+{
+	TArray<FBatchedLine>& Lines = CollisionQueryDrawDebug::GetScratchLines();
+	DrawDebugCollisionShape(Lines, Pos, Rotation, Shape, Color, DepthPriority, Thickness);
+	DrawDebugBatchedLines(World, Lines, bPersistentLines, LifeTime, DepthPriority);
+}
+
+void DrawDebugLine(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FColor& Color, uint8 DepthPriority, float Thickness)
 {
-	DrawDebugCapsule(World, Start, HalfHeight, Radius, Rotation, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawDebugCapsule(World, End, HalfHeight, Radius, Rotation, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+	OutLines.Emplace(Start, End, FLinearColor(Color), 0.f, Thickness, DepthPriority);
+}
 
-	const FVector Up = Rotation.GetUpVector();
+void DrawDebugSweptBox(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FQuat& Rotation, const FVector& HalfSize, const FColor& Color, uint8 DepthPriority, float Thickness)
+{
+	const FLinearColor LinearColor(Color);
 
-	const FMatrix Mat = FRotationMatrix::MakeFromZX(End - Start, Up);
-	const FVector YAxis = Mat.GetUnitAxis(EAxis::Y);
-	const FVector XAxis =  Mat.GetUnitAxis(EAxis::X);
+	OutLines.Reserve(OutLines.Num() + 32);
 
-	const float HalfLength = HalfHeight - Radius;
-	const FVector StartTop = Start + HalfLength*Up;
-	const FVector EndTop = End + HalfLength*Up;
+	// transform the unit box once, the box at the end of the sweep is the same vertices offset by the trace
+	FVector StartVertices[8];
+	CollisionQueryDrawDebug::TransformBox(Start, HalfSize, Rotation, StartVertices);
 
-	DrawDebugLine(World, StartTop + Radius*XAxis, EndTop + Radius*XAxis, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawDebugLine(World, StartTop + Radius*YAxis, EndTop + Radius*YAxis, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawDebugLine(World, StartTop - Radius*YAxis, EndTop - Radius*YAxis, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+	const FVector TraceVec = End - Start;
+	FVector EndVertices[8];
+	for (int32 VertexIdx = 0; VertexIdx < 8; ++VertexIdx)
+	{
+		EndVertices[VertexIdx] = StartVertices[VertexIdx] + TraceVec;
+	}
 
-	const FVector StartBottom = Start - HalfLength*Up;
-	const FVector EndBottom = End - HalfLength*Up;
+	CollisionQueryDrawDebug::AddBox(OutLines, StartVertices, LinearColor, DepthPriority, Thickness);
+	CollisionQueryDrawDebug::AddBox(OutLines, EndVertices, LinearColor, DepthPriority, Thickness);
 
-	DrawDebugLine(World, StartBottom - Radius*XAxis, EndBottom - Radius*XAxis, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawDebugLine(World, StartBottom + Radius*YAxis, EndBottom + Radius*YAxis, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
-	DrawDebugLine(World, StartBottom - Radius*YAxis, EndBottom - Radius*YAxis, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+	for (int32 VertexIdx = 0; VertexIdx < 8; ++VertexIdx)
+	{
+		OutLines.Emplace(StartVertices[VertexIdx], EndVertices[VertexIdx], LinearColor, 0.f, Thickness, DepthPriority);
+	}
 }
 
-void DrawDebugSweptCollisionShape(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+void DrawDebugSweptSphere(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, float Radius, const FColor& Color, uint8 DepthPriority, float Thickness)
+{
+	using namespace CollisionQueryDrawDebug;
+	AddSweptSphere<NumCircleSegments>(OutLines, Start, End, Radius, FLinearColor(Color), DepthPriority, Thickness);
+}
+
+void DrawDebugSweptCapsule(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FQuat& Rotation, float HalfHeight, float Radius, const FColor& Color, uint8 DepthPriority, float Thickness)
+{
+	using namespace CollisionQueryDrawDebug;
+	AddSweptCapsule<NumCircleSegments>(OutLines, Start, End, Rotation, HalfHeight, Radius, FLinearColor(Color), DepthPriority, Thickness);
+}
+
+void DrawDebugSweptCollisionShape(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority, float Thickness)
 {
 	switch (Shape.ShapeType)
 	{
 	case ECollisionShape::Line:
-		DrawDebugLine(World, Start, End, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+		DrawDebugLine(OutLines, Start, End, Color, DepthPriority, Thickness);
 		break;
 	case ECollisionShape::Box:
-		DrawDebugSweptBox(World, Start, End, Rotation, Shape.GetBox(), Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+		DrawDebugSweptBox(OutLines, Start, End, Rotation, Shape.GetBox(), Color, DepthPriority, Thickness);
 		break;
 	case ECollisionShape::Sphere:
-		DrawDebugSweptSphere(World, Start, End, Shape.GetSphereRadius(), Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+		DrawDebugSweptSphere(OutLines, Start, End, Shape.GetSphereRadius(), Color, DepthPriority, Thickness);
 		break;
 	case ECollisionShape::Capsule:
-		DrawDebugSweptCapsule(World, Start, End, Rotation, Shape.GetCapsuleHalfHeight(), Shape.GetCapsuleRadius(), Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+		DrawDebugSweptCapsule(OutLines, Start, End, Rotation, Shape.GetCapsuleHalfHeight(), Shape.GetCapsuleRadius(), Color, DepthPriority, Thickness);
 		break;
 	}
 }
 
-void DrawDebugCollisionShape(const UWorld* World, const FVector& Pos, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, bool bPersistentLines, float LifeTime, uint8 DepthPriority, float Thickness)
+void DrawDebugCollisionShape(TArray<FBatchedLine>& OutLines, const FVector& Pos, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority, float Thickness)
 {
+	using namespace CollisionQueryDrawDebug;
+
+	const FLinearColor LinearColor(Color);
+
 	switch (Shape.ShapeType)
 	{
 	case ECollisionShape::Line:
 		// don't do anything
 		break;
 	case ECollisionShape::Box:
-		DrawDebugBox(World, Pos, Shape.GetBox(), Rotation, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+	{
+		FVector Vertices[8];
+		TransformBox(Pos, Shape.GetBox(), Rotation, Vertices);
+		AddBox(OutLines, Vertices, LinearColor, DepthPriority, Thickness);
 		break;
+	}
 	case ECollisionShape::Sphere:
-		DrawCircle(World, Pos, Rotation.GetAxisX(), Rotation.GetAxisY(), Color, Shape.GetSphereRadius(), 16, bPersistentLines, LifeTime, DepthPriority, Thickness);
-		DrawCircle(World, Pos, Rotation.GetAxisX(), Rotation.GetAxisZ(), Color, Shape.GetSphereRadius(), 16, bPersistentLines, LifeTime, DepthPriority, Thickness);
+		AddSphere<NumCircleSegments>(OutLines, Pos, Rotation, Shape.GetSphereRadius(), LinearColor, DepthPriority, Thickness);
 		break;
 	case ECollisionShape::Capsule:
-		DrawDebugCapsule(World, Pos, Shape.GetCapsuleHalfHeight(), Shape.GetCapsuleRadius(), Rotation, Color, bPersistentLines, LifeTime, DepthPriority, Thickness);
+		AddCapsule<NumCircleSegments>(OutLines, Pos, Shape.GetCapsuleHalfHeight(), Shape.GetCapsuleRadius(), Rotation, LinearColor, DepthPriority, Thickness);
 		break;
 	}
 }
 
+const FCollisionQueryDebugDrawView& FCollisionQueryDebugDrawView::Get(const UWorld* World)
+{
+	check(IsInGameThread());
+
+	static FCollisionQueryDebugDrawView View;
+	static TWeakObjectPtr<const UWorld> ViewWorld;
+	static uint64 ViewFrame = 0;
+
+	if (ViewWorld == World && ViewFrame == GFrameCounter)
+	{
+		return View;
+	}
+
+	View = FCollisionQueryDebugDrawView();
+	ViewWorld = World;
+	ViewFrame = GFrameCounter;
+
+	if (!CVarCollisionQueryTestDrawLOD.GetValueOnGameThread())
+	{
+		return View;
+	}
+
+	ULocalPlayer* LocalPlayer = World && GEngine ? GEngine->GetFirstGamePlayer(const_cast<UWorld*>(World)) : nullptr;
+	if (!LocalPlayer || !LocalPlayer->ViewportClient || !LocalPlayer->ViewportClient->Viewport)
+	{
+		return View;
+	}
+
+	FSceneViewProjectionData ProjectionData;
+	if (!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData))
+	{
+		return View;
+	}
+
+	GetViewFrustumBounds(View.Frustum, ProjectionData.ComputeViewProjectionMatrix(), false);
+	View.Origin = ProjectionData.ViewOrigin;
+	View.ScreenScale = ProjectionData.ProjectionMatrix.M[1][1] * ProjectionData.GetConstrainedViewRect().Height() * 0.5f;
+	View.FallbackDistance = CVarCollisionQueryTestDrawLODFallbackDistance.GetValueOnGameThread();
+	View.bValid = true;
+
+	return View;
+}
+
+int32 FCollisionQueryDebugDrawView::GetNumCircleSegments(const FVector& Center, float Radius) const
+{
+	if (!bValid)
+	{
+		return CollisionQueryDrawDebug::NumCircleSegments;
+	}
+
+	const float Distance = FVector::Dist(Origin, Center);
+	if (FallbackDistance > 0.f && Distance > FallbackDistance)
+	{
+		return 0;
+	}
+
+	// projected radius in pixels, as in ComputeBoundsScreenSize
+	const float ScreenRadius = Radius * ScreenScale / FMath::Max(Distance, 1.f);
+
+	if (ScreenRadius < 2.f)
+	{
+		return 0;
+	}
+	else if (ScreenRadius < 16.f)
+	{
+		return 4;
+	}
+	else if (ScreenRadius < 64.f)
+	{
+		return 8;
+	}
+	else if (ScreenRadius < 256.f)
+	{
+		return 16;
+	}
+	return 32;
+}
+
+void DrawDebugSweptCollisionShape(TArray<FBatchedLine>& OutLines, const FCollisionQueryDebugDrawView& View, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority, float Thickness)
+{
+	using namespace CollisionQueryDrawDebug;
+
+	const FLinearColor LinearColor(Color);
+
+	const float ShapeRadius = Shape.GetExtent().Size();
+	const FBox Bounds = FBox(Start.ComponentMin(End), Start.ComponentMax(End)).ExpandBy(ShapeRadius);
+	if (View.bValid && !View.Frustum.IntersectBox(Bounds.GetCenter(), Bounds.GetExtent()))
+	{
+		return;
+	}
+
+	const int32 NumSegments = View.GetNumCircleSegments(Start, ShapeRadius);
+	if (NumSegments == 0 || Shape.ShapeType == ECollisionShape::Line)
+	{
+		OutLines.Emplace(Start, End, LinearColor, 0.f, Thickness, DepthPriority);
+		return;
+	}
+
+	switch (Shape.ShapeType)
+	{
+	case ECollisionShape::Box:
+		DrawDebugSweptBox(OutLines, Start, End, Rotation, Shape.GetBox(), Color, DepthPriority, Thickness);
+		break;
+	case ECollisionShape::Sphere:
+		DispatchNumSegments(NumSegments, [&](auto Segments)
+		{
+			AddSweptSphere<decltype(Segments)::Value>(OutLines, Start, End, Shape.GetSphereRadius(), LinearColor, DepthPriority, Thickness);
+		});
+		break;
+	case ECollisionShape::Capsule:
+		DispatchNumSegments(NumSegments, [&](auto Segments)
+		{
+			AddSweptCapsule<decltype(Segments)::Value>(OutLines, Start, End, Rotation, Shape.GetCapsuleHalfHeight(), Shape.GetCapsuleRadius(), LinearColor, DepthPriority, Thickness);
+		});
+		break;
+	}
+}
+
+void DrawDebugCollisionShape(TArray<FBatchedLine>& OutLines, const FCollisionQueryDebugDrawView& View, const FVector& Pos, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority, float Thickness)
+{
+	using namespace CollisionQueryDrawDebug;
+
+	if (Shape.ShapeType == ECollisionShape::Line)
+	{
+		return;
+	}
+
+	const FLinearColor LinearColor(Color);
+
+	const float ShapeRadius = Shape.GetExtent().Size();
+	if (View.bValid && !View.Frustum.IntersectSphere(Pos, ShapeRadius))
+	{
+		return;
+	}
+
+	const int32 NumSegments = View.GetNumCircleSegments(Pos, ShapeRadius);
+	if (NumSegments == 0)
+	{
+		AddMarker(OutLines, Pos, Shape.GetExtent().GetMin(), LinearColor, DepthPriority, Thickness);
+		return;
+	}
+
+	switch (Shape.ShapeType)
+	{
+	case ECollisionShape::Box:
+	{
+		FVector Vertices[8];
+		TransformBox(Pos, Shape.GetBox(), Rotation, Vertices);
+		AddBox(OutLines, Vertices, LinearColor, DepthPriority, Thickness);
+		break;
+	}
+	case ECollisionShape::Sphere:
+		DispatchNumSegments(NumSegments, [&](auto Segments)
+		{
+			AddSphere<decltype(Segments)::Value>(OutLines, Pos, Rotation, Shape.GetSphereRadius(), LinearColor, DepthPriority, Thickness);
+		});
+		break;
+	case ECollisionShape::Capsule:
+		DispatchNumSegments(NumSegments, [&](auto Segments)
+		{
+			AddCapsule<decltype(Segments)::Value>(OutLines, Pos, Shape.GetCapsuleHalfHeight(), Shape.GetCapsuleRadius(), Rotation, LinearColor, DepthPriority, Thickness);
+		});
+		break;
+	}
+}
+
+void DrawDebugBatchedLines(const UWorld* World, TArray<FBatchedLine>& Lines, bool bPersistentLines, float LifeTime, uint8 DepthPriority)
+{
+	if (Lines.Num() == 0)
+	{
+		return;
+	}
+
+	// NB: picks the same line batcher and life time as DrawDebugLine would
+	ULineBatchComponent* LineBatcher = nullptr;
+	if (World && GEngine->GetNetMode(World) != NM_DedicatedServer)
+	{
+		if (DepthPriority == SDPG_Foreground)
+		{
+			LineBatcher = World->ForegroundLineBatcher;
+		}
+		else if (bPersistentLines || LifeTime > 0.f)
+		{
+			LineBatcher = World->PersistentLineBatcher;
+		}
+		else
+		{
+			LineBatcher = World->LineBatcher;
+		}
+	}
+
+	if (LineBatcher)
+	{
+		const float LineLifeTime = bPersistentLines ? -1.f : (LifeTime > 0.f ? LifeTime : LineBatcher->DefaultLifeTime);
+		for (FBatchedLine& Line : Lines)
+		{
+			Line.RemainingLifeTime = LineLifeTime;
+		}
+
+		LineBatcher->DrawLines(Lines);
+	}
+
+	Lines.Reset();
+}
+
 #endif // ENABLE_DRAW_DEBUG
\ No newline at end of file
@@ -11,6 +11,8 @@
 
 #include "DrawDebugHelpers.h"
 #include "CollisionShape.h"
+#include "Components/LineBatchComponent.h"
+#include "ConvexVolume.h"
 
 #if ENABLE_DRAW_DEBUG
 
@@ -20,4 +22,43 @@ void DrawDebugSweptCapsule(const UWorld* World, const FVector& Start, const FVec
 void DrawDebugSweptCollisionShape(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, bool bPersistentLines = false, float LifeTime = -1.f, uint8 DepthPriority = 0, float Thickness = 0.f);
 void DrawDebugCollisionShape(const UWorld* World, const FVector& Pos, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, bool bPersistentLines = false, float LifeTime = -1.f, uint8 DepthPriority = 0, float Thickness = 0.f);
 
+// Batched variants of the above. These append their lines to OutLines instead of drawing them, so that many shapes can be
+// submitted to the world's line batcher at once with DrawDebugBatchedLines.
+void DrawDebugLine(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+void DrawDebugSweptBox(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FQuat& Rotation, const FVector& HalfSize, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+void DrawDebugSweptSphere(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, float Radius, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+void DrawDebugSweptCapsule(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FQuat& Rotation, float HalfHeight, float Radius, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+void DrawDebugSweptCollisionShape(TArray<FBatchedLine>& OutLines, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+void DrawDebugCollisionShape(TArray<FBatchedLine>& OutLines, const FVector& Pos, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+
+/**
+ * The view shapes are drawn for by the LOD variants of the batched helpers below. Shapes outside the view frustum are
+ * skipped, and the number of circle segments (4/8/16/32) is picked from the projected size of the shape. Shapes which
+ * are too small on screen, or beyond FallbackDistance, are drawn as a single line or marker. An invalid view draws
+ * everything at full detail.
+ */
+struct FCollisionQueryDebugDrawView
+{
+	FVector Origin = FVector::ZeroVector;
+	FConvexVolume Frustum;
+	float ScreenScale = 0.f; // projected size in pixels of a unit length at unit distance
+	float FallbackDistance = 10000.f;
+	bool bValid = false;
+
+	/**
+	 * Gets the view of the world's first local player, which is invalid if there is none or CollisionQueryTest.DrawLOD is 0.
+	 * Cached for the rest of the frame. Game thread only.
+	 */
+	static const FCollisionQueryDebugDrawView& Get(const UWorld* World);
+
+	/** Picks the number of circle segments for a shape of the given bounding radius, or zero to draw it as a line or marker. */
+	int32 GetNumCircleSegments(const FVector& Center, float Radius) const;
+};
+
+void DrawDebugSweptCollisionShape(TArray<FBatchedLine>& OutLines, const FCollisionQueryDebugDrawView& View, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+void DrawDebugCollisionShape(TArray<FBatchedLine>& OutLines, const FCollisionQueryDebugDrawView& View, const FVector& Pos, const FQuat& Rotation, const FCollisionShape& Shape, const FColor& Color, uint8 DepthPriority = 0, float Thickness = 0.f);
+
+/** Submits the lines to the world's line batcher with a single DrawLines call, then empties the array (keeping its allocation). */
+void DrawDebugBatchedLines(const UWorld* World, TArray<FBatchedLine>& Lines, bool bPersistentLines = false, float LifeTime = -1.f, uint8 DepthPriority = 0);
+
 #endif // ENABLE_DRAW_DEBUG
\ No newline at end of file
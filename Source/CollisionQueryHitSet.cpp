@@ -0,0 +1,118 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryHitSet.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryHitSet.h"
+#include "Components/PrimitiveComponent.h"
+
+void FCollisionQueryHitSet::Update(const TArray<FHitResult>& Hits, float Tolerance)
+{
+	Pending.Reset();
+	for (const FHitResult& Hit : Hits)
+	{
+		const FKey Key(Hit.GetComponent(), Hit.Item);
+		if (Pending.Contains(Key))
+		{
+			continue; // keep the nearest hit against each body
+		}
+
+		FCollisionQueryHitSetEntry& Entry = Pending.Add(Key);
+		Entry.Component = Key.Key;
+		Entry.Item = Key.Value;
+		Entry.Location = Hit.ImpactPoint;
+		Entry.Normal = Hit.ImpactNormal;
+		Entry.bBlocking = Hit.bBlockingHit;
+	}
+
+	ApplyPending(Tolerance);
+}
+
+void FCollisionQueryHitSet::Update(const TArray<FOverlapResult>& Overlaps, float Tolerance)
+{
+	Pending.Reset();
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		const UPrimitiveComponent* Component = Overlap.GetComponent();
+		const FKey Key(Component, Overlap.ItemIndex);
+		if (Pending.Contains(Key))
+		{
+			continue;
+		}
+
+		FCollisionQueryHitSetEntry& Entry = Pending.Add(Key);
+		Entry.Component = Key.Key;
+		Entry.Item = Key.Value;
+		if (Component)
+		{
+			Entry.Location = Component->Bounds.Origin;
+			Entry.Extent = Component->Bounds.BoxExtent;
+		}
+		Entry.bBlocking = Overlap.bBlockingHit;
+	}
+
+	ApplyPending(Tolerance);
+}
+
+void FCollisionQueryHitSet::ApplyPending(float Tolerance)
+{
+	Changes.Reset();
+
+	for (TPair<FKey, FCollisionQueryHitSetEntry>& Pair : Pending)
+	{
+		FCollisionQueryHitSetEntry& New = Pair.Value;
+		FCollisionQueryHitSetEntry* Existing = Entries.Find(Pair.Key);
+
+		if (!Existing)
+		{
+			New.Slot = FreeSlots.Num() > 0 ? FreeSlots.Pop(false) : NumSlots++;
+			Entries.Add(Pair.Key, New);
+			Changes.Add({ ECollisionQueryHitChangeType::Added, New });
+			continue;
+		}
+
+		const bool bChanged = Existing->bBlocking != New.bBlocking
+			|| !Existing->Location.Equals(New.Location, Tolerance)
+			|| !Existing->Normal.Equals(New.Normal, Tolerance)
+			|| !Existing->Extent.Equals(New.Extent, Tolerance);
+		if (bChanged)
+		{
+			New.Slot = Existing->Slot;
+			*Existing = New;
+			Changes.Add({ ECollisionQueryHitChangeType::Changed, New });
+		}
+	}
+
+	// every entry of the result is now in the set, so anything more in it is gone
+	if (Entries.Num() > Pending.Num())
+	{
+		for (auto It = Entries.CreateIterator(); It; ++It)
+		{
+			if (!Pending.Contains(It.Key()))
+			{
+				Changes.Add({ ECollisionQueryHitChangeType::Removed, It.Value() });
+				FreeSlots.Add(It.Value().Slot);
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	if (Entries.Num() == 0)
+	{
+		FreeSlots.Reset();
+		NumSlots = 0;
+	}
+}
+
+void FCollisionQueryHitSet::Reset()
+{
+	Entries.Reset();
+	Pending.Reset();
+	Changes.Reset();
+	FreeSlots.Reset();
+	NumSlots = 0;
+}
@@ -0,0 +1,83 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryHitSet.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldCollision.h"
+#include "UObject/ObjectKey.h"
+
+enum class ECollisionQueryHitChangeType : uint8
+{
+	Added,
+	Removed,
+	Changed
+};
+
+/**
+ * A hit or overlap of a multi query, identified by the component and body (item) it was against.
+ */
+struct FCollisionQueryHitSetEntry
+{
+	FObjectKey Component;
+	int32 Item = INDEX_NONE;
+
+	FVector Location = FVector::ZeroVector;	// impact point of a hit, or centre of the bounds of an overlapped component
+	FVector Normal = FVector::ZeroVector;	// impact normal of a hit, zero for overlaps
+	FVector Extent = FVector::ZeroVector;	// extent of the bounds of an overlapped component, zero for hits
+	bool bBlocking = false;
+
+	/** Stable index of the entry, for as long as it stays in the set. Freed slots are reused by later entries. */
+	int32 Slot = INDEX_NONE;
+};
+
+struct FCollisionQueryHitChange
+{
+	ECollisionQueryHitChangeType Type = ECollisionQueryHitChangeType::Added;
+	FCollisionQueryHitSetEntry Entry;	// the new state of the entry, or for removed entries its last state
+};
+
+/**
+ * The hits or overlaps of a multi query, kept between frames so that each new result can be reduced to the entries which
+ * were added, removed or changed since the last one. A result which is the same as the last gives no changes.
+ */
+class FCollisionQueryHitSet
+{
+public:
+	/**
+	 * Replaces the set with the given hits or overlaps and works out the changes. An entry has changed if it moved by more
+	 * than Tolerance, its normal or extent changed by more than Tolerance, or it switched between blocking and touching.
+	 */
+	void Update(const TArray<FHitResult>& Hits, float Tolerance);
+	void Update(const TArray<FOverlapResult>& Overlaps, float Tolerance);
+
+	/** Empties the set without reporting the entries as removed. */
+	void Reset();
+
+	TConstArrayView<FCollisionQueryHitChange> GetChanges() const { return Changes; }
+
+	int32 Num() const { return Entries.Num(); }
+
+	/** One more than the highest slot in use. */
+	int32 GetNumSlots() const { return NumSlots; }
+
+private:
+	using FKey = TPair<FObjectKey, int32>;
+
+	void ApplyPending(float Tolerance);
+
+	TMap<FKey, FCollisionQueryHitSetEntry> Entries;
+
+	/** The entries of the result being applied. Kept for its allocation. */
+	TMap<FKey, FCollisionQueryHitSetEntry> Pending;
+
+	TArray<FCollisionQueryHitChange> Changes;
+	TArray<int32> FreeSlots;
+	int32 NumSlots = 0;
+};
@@ -0,0 +1,475 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryRecording.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryRecording.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/OutputDeviceFile.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCollisionQueryRecording, Log, All);
+
+namespace CollisionQueryRecording
+{
+	static constexpr uint32 Magic = 0x43515243; // 'CQRC'
+
+	enum class EVersion : uint32
+	{
+		Initial = 1,
+
+		// add new versions above this line
+		LatestPlusOne,
+		Latest = LatestPlusOne - 1
+	};
+
+	enum class EEntryType : uint8
+	{
+		Actor,
+		Query
+	};
+
+	enum EQueryFlags : uint8
+	{
+		QF_TraceComplex			= 1 << 0,
+		QF_FindInitialOverlaps	= 1 << 1,
+		QF_IgnoreBlocks			= 1 << 2,
+		QF_IgnoreTouches		= 1 << 3,
+		QF_SkipNarrowPhase		= 1 << 4,
+	};
+
+	template<typename EnumType>
+	static void SerializeEnum(FArchive& Ar, EnumType& Value)
+	{
+		uint8 Byte = static_cast<uint8>(Value);
+		Ar << Byte;
+		Value = static_cast<EnumType>(Byte);
+	}
+
+	/**
+	 * Orders hits by location, then impact point. Overlaps come back in the order the acceleration structure visits them,
+	 * and touches at equal distance can swap, so neither order holds between a recording and its replay.
+	 */
+	static bool HitLess(const FCollisionQueryRecordHit& A, const FCollisionQueryRecordHit& B)
+	{
+		auto VectorLess = [](const FVector3f& U, const FVector3f& V)
+		{
+			return U.X != V.X ? U.X < V.X : (U.Y != V.Y ? U.Y < V.Y : U.Z < V.Z);
+		};
+
+		if (A.Location != B.Location)
+		{
+			return VectorLess(A.Location, B.Location);
+		}
+		return VectorLess(A.ImpactPoint, B.ImpactPoint);
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FCollisionQueryRecordHit& Hit)
+{
+	Ar << Hit.Location << Hit.ImpactPoint << Hit.ImpactNormal;
+	Ar << Hit.bBlockingHit;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FCollisionQueryRecord& Record)
+{
+	using namespace CollisionQueryRecording;
+
+	Ar << Record.Frame << Record.ActorIndex;
+
+	SerializeEnum(Ar, Record.Query);
+	SerializeEnum(Ar, Record.SingleMultiOrTest);
+	SerializeEnum(Ar, Record.BlockingAnyOrMulti);
+	SerializeEnum(Ar, Record.By);
+	Ar << Record.Channel;
+	if (Record.By == ECollisionQueryTestBy::Profile)
+	{
+		Ar << Record.CollisionProfileName;
+	}
+	Ar << Record.ShapeType;
+	if (Record.ShapeType != static_cast<uint8>(ECollisionShape::Line))
+	{
+		Ar << Record.ShapeExtent;
+	}
+	Ar << Record.QueryFlags << Record.MobilityType;
+	Ar.Serialize(Record.CollisionResponses.EnumArray, sizeof(Record.CollisionResponses.EnumArray));
+	Ar << Record.ObjectTypesToQuery;
+
+	Ar << Record.Start << Record.End << Record.Rot;
+
+	Ar << Record.bResult << Record.ExecutionTime;
+	Ar << Record.Hits;
+
+	return Ar;
+}
+
+void FCollisionQueryRecord::Set(const FCollisionQueryTestDesc& Desc, const FVector& InStart, const FVector& InEnd, const FQuat& InRot, const FCollisionQueryTestResult& Result)
+{
+	using namespace CollisionQueryRecording;
+
+	Query = Desc.Query;
+	SingleMultiOrTest = Desc.SingleMultiOrTest;
+	BlockingAnyOrMulti = Desc.BlockingAnyOrMulti;
+	By = Desc.By;
+	Channel = static_cast<uint8>(Desc.Channel);
+	CollisionProfileName.Reset();
+	if (By == ECollisionQueryTestBy::Profile)
+	{
+		Desc.CollisionProfileName.AppendString(CollisionProfileName);
+	}
+	ShapeType = static_cast<uint8>(Desc.CollisionShape.ShapeType);
+	ShapeExtent = FVector3f(Desc.CollisionShape.GetExtent());
+
+	QueryFlags = 0;
+	QueryFlags |= Desc.QueryParams.bTraceComplex ? QF_TraceComplex : 0;
+	QueryFlags |= Desc.QueryParams.bFindInitialOverlaps ? QF_FindInitialOverlaps : 0;
+	QueryFlags |= Desc.QueryParams.bIgnoreBlocks ? QF_IgnoreBlocks : 0;
+	QueryFlags |= Desc.QueryParams.bIgnoreTouches ? QF_IgnoreTouches : 0;
+	QueryFlags |= Desc.QueryParams.bSkipNarrowPhase ? QF_SkipNarrowPhase : 0;
+	MobilityType = static_cast<uint8>(Desc.QueryParams.MobilityType);
+	CollisionResponses = Desc.ResponseParams.CollisionResponse;
+	ObjectTypesToQuery = Desc.ObjectQueryParams.ObjectTypesToQuery;
+
+	Start = InStart;
+	End = InEnd;
+	Rot = InRot;
+
+	SetResult(Desc, Result);
+}
+
+void FCollisionQueryRecord::SetResult(const FCollisionQueryTestDesc& Desc, const FCollisionQueryTestResult& Result)
+{
+	bResult = Result.bResult;
+	ExecutionTime = Result.ExecutionTime;
+
+	Hits.Reset();
+
+	auto AddHit = [this](const FHitResult& Hit)
+	{
+		FCollisionQueryRecordHit& RecordHit = Hits.AddDefaulted_GetRef();
+		RecordHit.Location = FVector3f(Hit.Location);
+		RecordHit.ImpactPoint = FVector3f(Hit.ImpactPoint);
+		RecordHit.ImpactNormal = FVector3f(Hit.ImpactNormal);
+		RecordHit.bBlockingHit = Hit.bBlockingHit;
+	};
+
+	if (Desc.Query == ECollisionQueryTestType::Overlap)
+	{
+		for (const FOverlapResult& Overlap : Result.Overlaps)
+		{
+			FCollisionQueryRecordHit& RecordHit = Hits.AddDefaulted_GetRef();
+			if (const UPrimitiveComponent* Component = Overlap.GetComponent())
+			{
+				RecordHit.Location = FVector3f(Component->GetComponentLocation());
+			}
+			RecordHit.bBlockingHit = Overlap.bBlockingHit;
+		}
+	}
+	else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+	{
+		if (Result.bResult)
+		{
+			AddHit(Result.Hit);
+		}
+	}
+	else
+	{
+		for (const FHitResult& Hit : Result.Hits)
+		{
+			AddHit(Hit);
+		}
+	}
+}
+
+FCollisionQueryTestDesc FCollisionQueryRecord::MakeQueryDesc() const
+{
+	using namespace CollisionQueryRecording;
+
+	FCollisionQueryTestDesc Desc;
+	Desc.Query = Query;
+	Desc.SingleMultiOrTest = SingleMultiOrTest;
+	Desc.BlockingAnyOrMulti = BlockingAnyOrMulti;
+	Desc.By = By;
+	Desc.Channel = static_cast<ECollisionChannel>(Channel);
+	Desc.CollisionProfileName = CollisionProfileName.IsEmpty() ? NAME_None : FName(*CollisionProfileName);
+
+	Desc.QueryParams.bTraceComplex = (QueryFlags & QF_TraceComplex) != 0;
+	Desc.QueryParams.bFindInitialOverlaps = (QueryFlags & QF_FindInitialOverlaps) != 0;
+	Desc.QueryParams.bIgnoreBlocks = (QueryFlags & QF_IgnoreBlocks) != 0;
+	Desc.QueryParams.bIgnoreTouches = (QueryFlags & QF_IgnoreTouches) != 0;
+	Desc.QueryParams.bSkipNarrowPhase = (QueryFlags & QF_SkipNarrowPhase) != 0;
+	Desc.QueryParams.MobilityType = static_cast<EQueryMobilityType>(MobilityType);
+
+	Desc.ResponseParams.CollisionResponse = CollisionResponses;
+	Desc.ObjectQueryParams.ObjectTypesToQuery = ObjectTypesToQuery;
+
+	switch (static_cast<ECollisionShape::Type>(ShapeType))
+	{
+	case ECollisionShape::Box:
+		Desc.CollisionShape = FCollisionShape::MakeBox(ShapeExtent);
+		break;
+	case ECollisionShape::Sphere:
+		Desc.CollisionShape = FCollisionShape::MakeSphere(ShapeExtent.X);
+		break;
+	case ECollisionShape::Capsule:
+		Desc.CollisionShape = FCollisionShape::MakeCapsule(ShapeExtent.X, ShapeExtent.Z);
+		break;
+	default:
+		Desc.CollisionShape = FCollisionShape::LineShape;
+		break;
+	}
+
+	Desc.Prebuild();
+
+	return Desc;
+}
+
+FCollisionQueryRecorder::FCollisionQueryRecorder() = default;
+
+FCollisionQueryRecorder::~FCollisionQueryRecorder()
+{
+	EndRecording();
+}
+
+bool FCollisionQueryRecorder::BeginRecording(const FString& InFilename, const UWorld* World)
+{
+	using namespace CollisionQueryRecording;
+
+	EndRecording();
+
+	FileAr.Reset(IFileManager::Get().CreateFileWriter(*InFilename));
+	if (!FileAr)
+	{
+		UE_LOG(LogCollisionQueryRecording, Error, TEXT("Failed to open %s for recording"), *InFilename);
+		return false;
+	}
+
+	Filename = InFilename;
+	Writer = MakeUnique<FAsyncWriter>(*FileAr);
+	ActorIndices.Reset();
+	StartFrame = GFrameCounter;
+	NumRecords = 0;
+
+	uint32 FileMagic = Magic;
+	uint32 Version = static_cast<uint32>(EVersion::Latest);
+	FString MapName = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	FString EngineVersion = FEngineVersion::Current().ToString();
+
+	Buffer.Reset();
+	FMemoryWriter Ar(Buffer);
+	Ar << FileMagic << Version << MapName << EngineVersion;
+	Write();
+
+	UE_LOG(LogCollisionQueryRecording, Display, TEXT("Recording collision queries to %s"), *Filename);
+	return true;
+}
+
+void FCollisionQueryRecorder::EndRecording()
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	// the writer flushes its pending data when destroyed, so must go before the file
+	Writer.Reset();
+	FileAr.Reset();
+
+	UE_LOG(LogCollisionQueryRecording, Display, TEXT("Recorded %d collision queries to %s"), NumRecords, *Filename);
+}
+
+void FCollisionQueryRecorder::RecordQuery(const AActor* Actor, const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result)
+{
+	using namespace CollisionQueryRecording;
+
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	Buffer.Reset();
+	FMemoryWriter Ar(Buffer);
+
+	uint32 ActorIndex = 0;
+	if (const uint32* ExistingIndex = ActorIndices.Find(Actor))
+	{
+		ActorIndex = *ExistingIndex;
+	}
+	else
+	{
+		ActorIndex = static_cast<uint32>(ActorIndices.Num());
+		ActorIndices.Add(Actor, ActorIndex);
+
+		EEntryType EntryType = EEntryType::Actor;
+		FString ActorName = Actor->GetActorNameOrLabel();
+		SerializeEnum(Ar, EntryType);
+		Ar << ActorIndex << ActorName;
+	}
+
+	Record.Set(Desc, Start, End, Rot, Result);
+	Record.Frame = static_cast<uint32>(GFrameCounter - StartFrame);
+	Record.ActorIndex = ActorIndex;
+
+	EEntryType EntryType = EEntryType::Query;
+	SerializeEnum(Ar, EntryType);
+	Ar << Record;
+
+	Write();
+	++NumRecords;
+}
+
+void FCollisionQueryRecorder::Write()
+{
+	Writer->Serialize(Buffer.GetData(), Buffer.Num());
+}
+
+bool FCollisionQueryRecording::Load(const FString& Filename)
+{
+	using namespace CollisionQueryRecording;
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Filename))
+	{
+		UE_LOG(LogCollisionQueryRecording, Error, TEXT("Failed to read %s"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Ar(Data);
+
+	uint32 FileMagic = 0;
+	uint32 Version = 0;
+	Ar << FileMagic << Version;
+	if (FileMagic != Magic)
+	{
+		UE_LOG(LogCollisionQueryRecording, Error, TEXT("%s is not a collision query recording"), *Filename);
+		return false;
+	}
+	if (Version > static_cast<uint32>(EVersion::Latest))
+	{
+		UE_LOG(LogCollisionQueryRecording, Error, TEXT("%s was recorded with a newer version (%u) than is supported (%u)"), *Filename, Version, static_cast<uint32>(EVersion::Latest));
+		return false;
+	}
+
+	Ar << MapName << EngineVersion;
+
+	ActorNames.Reset();
+	Records.Reset();
+
+	while (!Ar.AtEnd() && !Ar.IsError())
+	{
+		EEntryType EntryType = EEntryType::Query;
+		SerializeEnum(Ar, EntryType);
+
+		if (EntryType == EEntryType::Actor)
+		{
+			uint32 ActorIndex = 0;
+			FString ActorName;
+			Ar << ActorIndex << ActorName;
+			if (ActorIndex > static_cast<uint32>(ActorNames.Num()))
+			{
+				Ar.SetError(); // actors are written in index order, so anything past the next index is corrupt
+				break;
+			}
+			if (ActorIndex == static_cast<uint32>(ActorNames.Num()))
+			{
+				ActorNames.AddDefaulted();
+			}
+			ActorNames[ActorIndex] = MoveTemp(ActorName);
+		}
+		else if (EntryType == EEntryType::Query)
+		{
+			FCollisionQueryRecord Record;
+			Ar << Record;
+			if (!Ar.IsError())
+			{
+				Records.Add(MoveTemp(Record));
+			}
+		}
+		else
+		{
+			Ar.SetError();
+		}
+	}
+
+	if (Ar.IsError())
+	{
+		// a recording which was not closed cleanly may be truncated, so keep what was read
+		UE_LOG(LogCollisionQueryRecording, Warning, TEXT("%s is truncated or corrupt, read %d queries"), *Filename, Records.Num());
+	}
+
+	return true;
+}
+
+FCollisionQueryReplayReport FCollisionQueryRecording::Replay(const UWorld* World, float Tolerance) const
+{
+	using namespace CollisionQueryRecording;
+
+	FCollisionQueryReplayReport Report;
+
+	FCollisionQueryTestResult Result;
+	FCollisionQueryRecord Replayed;
+	TArray<FCollisionQueryRecordHit> RecordedHits;
+
+	for (const FCollisionQueryRecord& Record : Records)
+	{
+		const FCollisionQueryTestDesc Desc = Record.MakeQueryDesc();
+		Desc.Execute(World, Record.Start, Record.End, Record.Rot, Result);
+		Replayed.SetResult(Desc, Result);
+
+		++Report.NumQueries;
+		Report.RecordedTime += Record.ExecutionTime;
+		Report.ReplayedTime += Replayed.ExecutionTime;
+
+		FString Diff;
+		if (Replayed.bResult != Record.bResult)
+		{
+			Diff = FString::Printf(TEXT("result %d -> %d"), Record.bResult ? 1 : 0, Replayed.bResult ? 1 : 0);
+		}
+		else if (Replayed.Hits.Num() != Record.Hits.Num())
+		{
+			Diff = FString::Printf(TEXT("%d hits -> %d hits"), Record.Hits.Num(), Replayed.Hits.Num());
+		}
+		else
+		{
+			RecordedHits = Record.Hits;
+			RecordedHits.Sort(&HitLess);
+			Replayed.Hits.Sort(&HitLess);
+
+			for (int32 HitIdx = 0; HitIdx < RecordedHits.Num(); ++HitIdx)
+			{
+				const FCollisionQueryRecordHit& RecordHit = RecordedHits[HitIdx];
+				const FCollisionQueryRecordHit& ReplayedHit = Replayed.Hits[HitIdx];
+				if (RecordHit.bBlockingHit != ReplayedHit.bBlockingHit
+					|| !RecordHit.Location.Equals(ReplayedHit.Location, Tolerance)
+					|| !RecordHit.ImpactPoint.Equals(ReplayedHit.ImpactPoint, Tolerance)
+					|| !RecordHit.ImpactNormal.Equals(ReplayedHit.ImpactNormal, Tolerance))
+				{
+					Diff = FString::Printf(TEXT("hit %d differs, location %s -> %s, normal %s -> %s"), HitIdx,
+						*RecordHit.Location.ToString(), *ReplayedHit.Location.ToString(),
+						*RecordHit.ImpactNormal.ToString(), *ReplayedHit.ImpactNormal.ToString());
+					break;
+				}
+			}
+		}
+
+		if (!Diff.IsEmpty())
+		{
+			++Report.NumDiffs;
+
+			const FString ActorName = ActorNames.IsValidIndex(static_cast<int32>(Record.ActorIndex)) ? ActorNames[Record.ActorIndex] : FString(TEXT("Unknown"));
+			Report.Diffs.Add(FString::Printf(TEXT("Frame %u %s: %s: %s"), Record.Frame, *ActorName, *Desc.ToString(), *Diff));
+		}
+	}
+
+	return Report;
+}
@@ -0,0 +1,137 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryRecording.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "CollisionQueryTestActor.h"
+
+class FAsyncWriter;
+
+/**
+ * A hit or overlap as stored in a recording. Positions are stored at float precision to keep recordings small.
+ */
+struct FCollisionQueryRecordHit
+{
+	FVector3f Location = FVector3f::ZeroVector;
+	FVector3f ImpactPoint = FVector3f::ZeroVector;
+	FVector3f ImpactNormal = FVector3f::ZeroVector;
+	bool bBlockingHit = false;
+
+	friend FArchive& operator<<(FArchive& Ar, FCollisionQueryRecordHit& Hit);
+};
+
+/**
+ * The inputs and outputs of one recorded query. The query transforms are stored at full precision so that replays
+ * perform exactly the same query.
+ */
+struct FCollisionQueryRecord
+{
+	uint32 Frame = 0;
+	uint32 ActorIndex = 0;
+
+	ECollisionQueryTestType Query = ECollisionQueryTestType::LineTrace;
+	ECollisionQueryTestSingleMultiOrTest SingleMultiOrTest = ECollisionQueryTestSingleMultiOrTest::Single;
+	ECollisionQueryTestBlockingAnyOrMulti BlockingAnyOrMulti = ECollisionQueryTestBlockingAnyOrMulti::Multi;
+	ECollisionQueryTestBy By = ECollisionQueryTestBy::Channel;
+	uint8 Channel = 0;
+	FString CollisionProfileName;
+	uint8 ShapeType = 0;
+	FVector3f ShapeExtent = FVector3f::ZeroVector;
+	uint8 QueryFlags = 0;
+	uint8 MobilityType = 0;
+	FCollisionResponseContainer CollisionResponses;
+	int32 ObjectTypesToQuery = 0;
+
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FQuat Rot = FQuat::Identity;
+
+	bool bResult = false;
+	double ExecutionTime = 0.0; // seconds
+	TArray<FCollisionQueryRecordHit> Hits;
+
+	/** Fills in the record from a query and its result. Reuses the record's allocations. */
+	void Set(const FCollisionQueryTestDesc& Desc, const FVector& InStart, const FVector& InEnd, const FQuat& InRot, const FCollisionQueryTestResult& Result);
+
+	/** Fills in only the outputs of the record from the result of a query. */
+	void SetResult(const FCollisionQueryTestDesc& Desc, const FCollisionQueryTestResult& Result);
+
+	/** Rebuilds the description of the recorded query. */
+	FCollisionQueryTestDesc MakeQueryDesc() const;
+
+	friend FArchive& operator<<(FArchive& Ar, FCollisionQueryRecord& Record);
+};
+
+/**
+ * Writes the queries of test actors to a recording file. The file is written on a background thread through an
+ * FAsyncWriter so that recording does not stall the game thread on IO.
+ *
+ * File layout: a header (magic, version, map name, engine version) followed by a stream of tagged entries, each either
+ * an actor name (written the first time the actor records a query) or a query record referring to an actor by index.
+ */
+class FCollisionQueryRecorder
+{
+public:
+	FCollisionQueryRecorder();
+	~FCollisionQueryRecorder();
+
+	bool BeginRecording(const FString& Filename, const UWorld* World);
+	void EndRecording();
+	bool IsRecording() const { return Writer.IsValid(); }
+
+	void RecordQuery(const AActor* Actor, const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result);
+
+	const FString& GetFilename() const { return Filename; }
+	int32 GetNumRecords() const { return NumRecords; }
+
+private:
+	void Write();
+
+	FString Filename;
+	TUniquePtr<FArchive> FileAr;
+	TUniquePtr<FAsyncWriter> Writer;
+
+	TMap<FObjectKey, uint32> ActorIndices;
+	uint64 StartFrame = 0;
+	int32 NumRecords = 0;
+
+	/** Scratch record and buffer reused for every query. */
+	FCollisionQueryRecord Record;
+	TArray<uint8> Buffer;
+};
+
+/**
+ * Differences between a recording and a replay of it against the current world.
+ */
+struct FCollisionQueryReplayReport
+{
+	int32 NumQueries = 0;
+	int32 NumDiffs = 0;
+	double RecordedTime = 0.0; // seconds, sum over all queries
+	double ReplayedTime = 0.0; // seconds, sum over all queries
+	TArray<FString> Diffs;
+};
+
+/**
+ * A recording loaded from file, which can be replayed against a world.
+ */
+struct FCollisionQueryRecording
+{
+	FString MapName;
+	FString EngineVersion;
+	TArray<FString> ActorNames;
+	TArray<FCollisionQueryRecord> Records;
+
+	bool Load(const FString& Filename);
+
+	/** Re-runs every recorded query and compares its result to the recorded one. Hits and overlaps are compared sorted by location, within Tolerance. */
+	FCollisionQueryReplayReport Replay(const UWorld* World, float Tolerance = 0.01f) const;
+};
@@ -0,0 +1,343 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryResultComponent.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryResultComponent.h"
+#include "DynamicMeshBuilder.h"
+#include "Engine/Engine.h"
+#include "LocalVertexFactory.h"
+#include "Materials/Material.h"
+#include "Misc/App.h"
+#include "PrimitiveSceneProxy.h"
+#include "RenderingThread.h"
+#include "StaticMeshResources.h"
+
+/**
+ * Vertices sent from the component to its scene proxy. Only the changed range is included.
+ */
+struct FCollisionQueryResultUpdate
+{
+	int32 FirstVertex = 0;
+	int32 NumVertices = 0; // total number of vertices to draw
+	TArray<FVector3f> Positions;
+	TArray<FColor> Colors;
+};
+
+/**
+ * Renders the component's lines from vertex buffers which live as long as the proxy. Follows the cable component in
+ * using FStaticMeshVertexBuffers with a local vertex factory, and locking the buffers to write to them.
+ */
+class FCollisionQueryResultSceneProxy final : public FPrimitiveSceneProxy
+{
+public:
+	SIZE_T GetTypeHash() const override
+	{
+		static size_t UniquePointer;
+		return reinterpret_cast<size_t>(&UniquePointer);
+	}
+
+	FCollisionQueryResultSceneProxy(UCollisionQueryResultComponent* Component)
+		: FPrimitiveSceneProxy(Component)
+		, Capacity(FMath::Max(Component->ProxyCapacity, 2))
+		, VertexFactory(GetScene().GetFeatureLevel(), "FCollisionQueryResultSceneProxy")
+		, MaterialRenderProxy(GEngine->VertexColorMaterial->GetRenderProxy())
+	{
+		VertexBuffers.InitWithDummyData(&VertexFactory, Capacity);
+
+		// lines are drawn as a non-indexed list, the index buffer just counts up
+		IndexBuffer.Indices.SetNumUninitialized(Capacity);
+		for (int32 Index = 0; Index < Capacity; ++Index)
+		{
+			IndexBuffer.Indices[Index] = Index;
+		}
+		BeginInitResource(&IndexBuffer);
+	}
+
+	virtual ~FCollisionQueryResultSceneProxy()
+	{
+		VertexBuffers.PositionVertexBuffer.ReleaseResource();
+		VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+		VertexBuffers.ColorVertexBuffer.ReleaseResource();
+		IndexBuffer.ReleaseResource();
+		VertexFactory.ReleaseResource();
+	}
+
+	void Update_RenderThread(FRHICommandListImmediate& RHICmdList, const FCollisionQueryResultUpdate& Update)
+	{
+		check(IsInRenderingThread());
+		check(Update.NumVertices <= Capacity && Update.FirstVertex + Update.Positions.Num() <= Capacity);
+
+		NumVertices = Update.NumVertices;
+
+		const int32 NumUpdated = Update.Positions.Num();
+		if (NumUpdated == 0)
+		{
+			return;
+		}
+
+		FPositionVertexBuffer& PositionBuffer = VertexBuffers.PositionVertexBuffer;
+		void* PositionData = RHICmdList.LockBuffer(PositionBuffer.VertexBufferRHI, Update.FirstVertex * sizeof(FVector3f), NumUpdated * sizeof(FVector3f), RLM_WriteOnly);
+		FMemory::Memcpy(PositionData, Update.Positions.GetData(), NumUpdated * sizeof(FVector3f));
+		RHICmdList.UnlockBuffer(PositionBuffer.VertexBufferRHI);
+
+		FColorVertexBuffer& ColorBuffer = VertexBuffers.ColorVertexBuffer;
+		void* ColorData = RHICmdList.LockBuffer(ColorBuffer.VertexBufferRHI, Update.FirstVertex * sizeof(FColor), NumUpdated * sizeof(FColor), RLM_WriteOnly);
+		FMemory::Memcpy(ColorData, Update.Colors.GetData(), NumUpdated * sizeof(FColor));
+		RHICmdList.UnlockBuffer(ColorBuffer.VertexBufferRHI);
+	}
+
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
+	{
+		if (NumVertices < 2)
+		{
+			return;
+		}
+
+		for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ++ViewIndex)
+		{
+			if (!(VisibilityMap & (1 << ViewIndex)))
+			{
+				continue;
+			}
+
+			FMeshBatch& Mesh = Collector.AllocateMesh();
+			Mesh.VertexFactory = &VertexFactory;
+			Mesh.MaterialRenderProxy = MaterialRenderProxy;
+			Mesh.Type = PT_LineList;
+			Mesh.DepthPriorityGroup = SDPG_World;
+			Mesh.bCanApplyViewModeOverrides = false;
+			Mesh.bDisableBackfaceCulling = true;
+			Mesh.CastShadow = false;
+
+			FMeshBatchElement& Element = Mesh.Elements[0];
+			Element.IndexBuffer = &IndexBuffer;
+			Element.FirstIndex = 0;
+			Element.NumPrimitives = NumVertices / 2;
+			Element.MinVertexIndex = 0;
+			Element.MaxVertexIndex = NumVertices - 1;
+			Element.PrimitiveUniformBuffer = GetUniformBuffer();
+
+			Collector.AddMesh(ViewIndex, Mesh);
+		}
+	}
+
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+	{
+		FPrimitiveViewRelevance Result;
+		Result.bDrawRelevance = IsShown(View);
+		Result.bDynamicRelevance = true;
+		Result.bRenderInMainPass = ShouldRenderInMainPass();
+		Result.bOpaque = true;
+		return Result;
+	}
+
+	virtual uint32 GetMemoryFootprint() const override
+	{
+		return sizeof(*this) + GetAllocatedSize();
+	}
+
+private:
+	const int32 Capacity;
+	int32 NumVertices = 0;
+
+	FStaticMeshVertexBuffers VertexBuffers;
+	FDynamicMeshIndexBuffer32 IndexBuffer;
+	FLocalVertexFactory VertexFactory;
+	FMaterialRenderProxy* MaterialRenderProxy = nullptr;
+};
+
+UCollisionQueryResultComponent::UCollisionQueryResultComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	// vertices are in world space
+	SetUsingAbsoluteLocation(true);
+	SetUsingAbsoluteRotation(true);
+	SetUsingAbsoluteScale(true);
+
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	CastShadow = false;
+	bHiddenInGame = false;
+	bIsEditorOnly = false;
+}
+
+void UCollisionQueryResultComponent::AddVertex(const FVector& Position, const FColor& Color)
+{
+	SetVertex(NumRetainedVertices + NumVertices++, Position, Color);
+	PendingBounds += Position;
+}
+
+void UCollisionQueryResultComponent::SetVertex(int32 VertexIdx, const FVector& Position, const FColor& Color)
+{
+	const FVector3f Position3f(Position);
+
+	// compare against the vertex left from the last commit, so that only changed vertices need uploading
+	if (VertexIdx < Positions.Num())
+	{
+		if (Positions[VertexIdx] == Position3f && Colors[VertexIdx] == Color)
+		{
+			return;
+		}
+		Positions[VertexIdx] = Position3f;
+		Colors[VertexIdx] = Color;
+	}
+	else
+	{
+		Positions.Add(Position3f);
+		Colors.Add(Color);
+	}
+
+	FirstDirtyVertex = FMath::Min(FirstDirtyVertex, VertexIdx);
+	LastDirtyVertex = FMath::Max(LastDirtyVertex, VertexIdx);
+}
+
+void UCollisionQueryResultComponent::AddLine(const FVector& Start, const FVector& End, const FColor& Color)
+{
+	AddVertex(Start, Color);
+	AddVertex(End, Color);
+}
+
+void UCollisionQueryResultComponent::AddPoint(const FVector& Position, float Size, const FColor& Color)
+{
+	const float HalfSize = Size * 0.5f;
+	AddLine(Position - FVector(HalfSize, 0.f, 0.f), Position + FVector(HalfSize, 0.f, 0.f), Color);
+	AddLine(Position - FVector(0.f, HalfSize, 0.f), Position + FVector(0.f, HalfSize, 0.f), Color);
+	AddLine(Position - FVector(0.f, 0.f, HalfSize), Position + FVector(0.f, 0.f, HalfSize), Color);
+}
+
+void UCollisionQueryResultComponent::SetRetainedLine(int32 LineIdx, const FVector& Start, const FVector& End, const FColor& Color)
+{
+	const int32 VertexIdx = LineIdx * 2;
+	if (VertexIdx + 2 > NumRetainedVertices)
+	{
+		// make room by moving the added vertices up. The degenerate lines inserted draw nothing until they are set
+		const int32 NewNumRetainedVertices = FMath::RoundUpToPowerOfTwo(VertexIdx + 2);
+		const int32 NumInserted = NewNumRetainedVertices - NumRetainedVertices;
+		Positions.InsertZeroed(NumRetainedVertices, NumInserted);
+		Colors.InsertZeroed(NumRetainedVertices, NumInserted);
+
+		FirstDirtyVertex = FMath::Min(FirstDirtyVertex, NumRetainedVertices);
+		LastDirtyVertex = FMath::Max(LastDirtyVertex, Positions.Num() - 1);
+		NumRetainedVertices = NewNumRetainedVertices;
+	}
+
+	SetVertex(VertexIdx, Start, Color);
+	SetVertex(VertexIdx + 1, End, Color);
+
+	// grows only, as lines are usually cleared by making them degenerate where they were
+	RetainedBounds += Start;
+	RetainedBounds += End;
+}
+
+void UCollisionQueryResultComponent::ClearRetainedLines()
+{
+	if (NumRetainedVertices == 0)
+	{
+		return;
+	}
+
+	Positions.RemoveAt(0, NumRetainedVertices, false);
+	Colors.RemoveAt(0, NumRetainedVertices, false);
+
+	// every vertex has moved
+	FirstDirtyVertex = 0;
+	LastDirtyVertex = Positions.Num() - 1;
+	NumRetainedVertices = 0;
+	RetainedBounds = FBox(ForceInit);
+}
+
+void UCollisionQueryResultComponent::Commit()
+{
+	const int32 PrevNumCommitted = Positions.Num();
+	const int32 NumCommitted = NumRetainedVertices + NumVertices;
+
+	// drop the vertices left over from a larger commit, they no longer need comparing against
+	Positions.SetNum(NumCommitted, false);
+	Colors.SetNum(NumCommitted, false);
+	LastDirtyVertex = FMath::Min(LastDirtyVertex, NumCommitted - 1);
+
+	const FBox Bounds = PendingBounds + RetainedBounds;
+	if (!LocalBounds.Equals(Bounds))
+	{
+		LocalBounds = Bounds;
+		UpdateBounds();
+		MarkRenderTransformDirty();
+	}
+
+	if (NumCommitted > ProxyCapacity)
+	{
+		// the proxy's buffers are too small, create a new proxy with room to grow. It uploads every vertex when created
+		ProxyCapacity = FMath::RoundUpToPowerOfTwo(NumCommitted);
+		MarkRenderStateDirty();
+	}
+	else if (SceneProxy && (LastDirtyVertex >= FirstDirtyVertex || NumCommitted != PrevNumCommitted))
+	{
+		FCollisionQueryResultUpdate Update;
+		Update.NumVertices = NumCommitted;
+		if (LastDirtyVertex >= FirstDirtyVertex)
+		{
+			Update.FirstVertex = FirstDirtyVertex;
+			Update.Positions.Append(Positions.GetData() + FirstDirtyVertex, LastDirtyVertex - FirstDirtyVertex + 1);
+			Update.Colors.Append(Colors.GetData() + FirstDirtyVertex, LastDirtyVertex - FirstDirtyVertex + 1);
+		}
+
+		FCollisionQueryResultSceneProxy* Proxy = static_cast<FCollisionQueryResultSceneProxy*>(SceneProxy);
+		ENQUEUE_RENDER_COMMAND(UpdateCollisionQueryResult)(
+			[Proxy, Update = MoveTemp(Update)](FRHICommandListImmediate& RHICmdList)
+			{
+				Proxy->Update_RenderThread(RHICmdList, Update);
+			});
+	}
+
+	NumVertices = 0;
+	FirstDirtyVertex = MAX_int32;
+	LastDirtyVertex = -1;
+	PendingBounds = FBox(ForceInit);
+}
+
+FPrimitiveSceneProxy* UCollisionQueryResultComponent::CreateSceneProxy()
+{
+	if (!FApp::CanEverRender() || !GEngine || !GEngine->VertexColorMaterial)
+	{
+		return nullptr;
+	}
+
+	ProxyCapacity = FMath::Max(ProxyCapacity, static_cast<int32>(FMath::RoundUpToPowerOfTwo(FMath::Max(Positions.Num(), 2))));
+	FCollisionQueryResultSceneProxy* Proxy = new FCollisionQueryResultSceneProxy(this);
+
+	// a new proxy starts empty, so send it every vertex
+	FCollisionQueryResultUpdate Update;
+	Update.NumVertices = Positions.Num();
+	Update.Positions = Positions;
+	Update.Colors = Colors;
+
+	ENQUEUE_RENDER_COMMAND(InitCollisionQueryResult)(
+		[Proxy, Update = MoveTemp(Update)](FRHICommandListImmediate& RHICmdList)
+		{
+			Proxy->Update_RenderThread(RHICmdList, Update);
+		});
+
+	return Proxy;
+}
+
+FBoxSphereBounds UCollisionQueryResultComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if (!LocalBounds.IsValid)
+	{
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f);
+	}
+	return FBoxSphereBounds(LocalBounds.TransformBy(LocalToWorld));
+}
+
+void UCollisionQueryResultComponent::GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials) const
+{
+	if (GEngine && GEngine->VertexColorMaterial)
+	{
+		OutMaterials.Add(GEngine->VertexColorMaterial);
+	}
+}
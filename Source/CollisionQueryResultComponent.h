@@ -0,0 +1,87 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryResultComponent.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+
+#include "CollisionQueryResultComponent.generated.h"
+
+/**
+ * Draws query results (hit points, normals and shape outlines) as world space lines kept in persistent vertex buffers
+ * by its own scene proxy, instead of as debug lines rebuilt and submitted every frame.
+ *
+ * Lines are added each frame with AddLine/AddPoint and sent to the renderer with Commit. Only the range of vertices which
+ * changed since the last commit is uploaded, and the vertex buffers are only reallocated when they need to grow. When the
+ * process cannot render (eg. -nullrhi) no proxy is created and the lines are only kept on the CPU.
+ */
+UCLASS(ClassGroup=Rendering, HideCategories=(Collision, Physics, Object, LOD, Lighting, TextureStreaming))
+class UCollisionQueryResultComponent : public UPrimitiveComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCollisionQueryResultComponent(const FObjectInitializer& ObjectInitializer);
+
+	void AddLine(const FVector& Start, const FVector& End, const FColor& Color);
+
+	/** Adds a point as three axis aligned lines of length Size, in world units. */
+	void AddPoint(const FVector& Position, float Size, const FColor& Color);
+
+	/** Sends the lines added since the last commit to the renderer, replacing the previous ones. */
+	void Commit();
+
+	/**
+	 * Sets one of the retained lines, which unlike added lines stay drawn across commits until set again or cleared. Results
+	 * which rarely change can be drawn with these and only the lines which changed set, rather than adding every line each
+	 * frame. Retained lines which were never set are drawn as nothing.
+	 */
+	void SetRetainedLine(int32 LineIdx, const FVector& Start, const FVector& End, const FColor& Color);
+
+	void ClearRetainedLines();
+
+	int32 GetNumVertices() const { return NumVertices; }
+	const TArray<FVector3f>& GetPositions() const { return Positions; }
+	const TArray<FColor>& GetColors() const { return Colors; }
+
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+	virtual void GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials = false) const override;
+
+private:
+	void AddVertex(const FVector& Position, const FColor& Color);
+	void SetVertex(int32 VertexIdx, const FVector& Position, const FColor& Color);
+
+	/**
+	 * Line list vertices, the retained lines followed by those added since the last commit. Entries past the added vertices
+	 * are left over from an earlier frame, kept to compare against.
+	 */
+	TArray<FVector3f> Positions;
+	TArray<FColor> Colors;
+
+	/** Number of vertices added since the last commit. */
+	int32 NumVertices = 0;
+
+	/** Number of vertices reserved at the start of the buffers for retained lines, rounded up to a power of two. */
+	int32 NumRetainedVertices = 0;
+	FBox RetainedBounds = FBox(ForceInit);
+
+	/** Range of vertices which differ from those last sent to the renderer. */
+	int32 FirstDirtyVertex = MAX_int32;
+	int32 LastDirtyVertex = -1;
+
+	/** Number of vertices the current scene proxy's buffers can hold. */
+	int32 ProxyCapacity = 0;
+
+	FBox LocalBounds = FBox(ForceInit);
+	FBox PendingBounds = FBox(ForceInit);
+
+	friend class FCollisionQueryResultSceneProxy;
+};
@@ -8,8 +8,51 @@
 // Author		-> George Prosser (Studio Gobo)
 
 #include "CollisionQueryTestActor.h"
+#include "CollisionQueryCapture.h"
 #include "CollisionQueryDrawDebugHelpers.h"
+#include "CollisionQueryResultComponent.h"
+#include "CollisionQueryTestSubsystem.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SplineComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/LowLevelMemTracker.h"
 #include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Math/RandomStream.h"
+#include "Templates/IntegerSequence.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.inl"
+
+DECLARE_CYCLE_STAT(TEXT("Line Trace"), STAT_CollisionQueryTest_LineTrace, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Sweep"), STAT_CollisionQueryTest_Sweep, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Overlap"), STAT_CollisionQueryTest_Overlap, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Async Issue"), STAT_CollisionQueryTest_AsyncIssue, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Pattern"), STAT_CollisionQueryTest_Pattern, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Path"), STAT_CollisionQueryTest_Path, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Compare"), STAT_CollisionQueryTest_Compare, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Phase Breakdown"), STAT_CollisionQueryTest_PhaseBreakdown, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Traversal"), STAT_CollisionQueryTest_Traversal, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Hit Set Diff"), STAT_CollisionQueryTest_HitSetDiff, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Raw Compare"), STAT_CollisionQueryTest_RawCompare, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Stress Test"), STAT_CollisionQueryTest_StressTest, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Heatmap"), STAT_CollisionQueryTest_Heatmap, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Cache Revalidation"), STAT_CollisionQueryTest_CacheRevalidation, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cached Results Reused"), STAT_CollisionQueryTest_CachedResultsReused, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Heatmap Cells Sampled"), STAT_CollisionQueryTest_HeatmapCellsSampled, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Result Allocations"), STAT_CollisionQueryTest_ResultAllocations, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Result Bytes Allocated"), STAT_CollisionQueryTest_ResultBytesAllocated, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits Added"), STAT_CollisionQueryTest_HitsAdded, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits Removed"), STAT_CollisionQueryTest_HitsRemoved, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits Changed"), STAT_CollisionQueryTest_HitsChanged, STATGROUP_CollisionQueryTest);
+
+static TAutoConsoleVariable<float> CVarCollisionQueryTestResultFadeTime(
+	TEXT("CollisionQueryTest.ResultFadeTime"),
+	1.f,
+	TEXT("Age in seconds at which a stale result from an over budget UCollisionQueryTestSubsystem is drawn fully faded. 0 to not fade stale results."));
 
 ACollisionQueryTestActor::ACollisionQueryTestActor(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -29,283 +72,2395 @@ ACollisionQueryTestActor::ACollisionQueryTestActor(const FObjectInitializer& Obj
 #if WITH_EDITORONLY_DATA
 	EndComponent->bVisualizeComponent = true;
 #endif
-}
-
-void ACollisionQueryTestActor::Tick(float DeltaSeconds)
-{
-	const float LineThickness = 0.f;
-	const float PointSize = 16.f;
-	
-	UWorld* World = GetWorld();
 
-	const FVector Pos = GetActorLocation();
-	const FQuat Rot = GetActorQuat();
+	PathComponent = ObjectInitializer.CreateDefaultSubobject<USplineComponent>(this, TEXT("Path"));
+	PathComponent->SetupAttachment(StartComponent);
+	PathComponent->SetSplinePoints({ FVector::ZeroVector, FVector(200.f, 0.f, 0.f) }, ESplineCoordinateSpace::Local);
 
-	const FVector Start = Pos;
-	const FVector End = EndComponent->GetComponentLocation();
+	ResultComponent = ObjectInitializer.CreateDefaultSubobject<UCollisionQueryResultComponent>(this, TEXT("Result"));
+	ResultComponent->SetupAttachment(StartComponent);
 
-	FCollisionQueryParams QueryParams;
-	QueryParams.bTraceComplex = bTraceComplex;
-	QueryParams.bFindInitialOverlaps = bFindInitialOverlaps;
-	QueryParams.bIgnoreBlocks = bIgnoreBlocks;
-	QueryParams.bIgnoreTouches = bIgnoreTouches;
-	QueryParams.bSkipNarrowPhase = bSkipNarrowPhase;
-	QueryParams.MobilityType = ConvertToQueryMobilityType(MobilityType);
+	AsyncTraceDelegate.BindUObject(this, &ACollisionQueryTestActor::OnAsyncTraceCompleted);
+	AsyncOverlapDelegate.BindUObject(this, &ACollisionQueryTestActor::OnAsyncOverlapCompleted);
+}
 
-	FCollisionResponseParams ResponseParams;
-	ResponseParams.CollisionResponse = CollisionResponses;
+void FCollisionQueryTestResult::Reset()
+{
+	bResult = false;
+	ExecutionTime = 0.0;
+	Hit = FHitResult();
+	Hits.Reset();
+	Overlaps.Reset();
+}
 
-	FCollisionObjectQueryParams ObjectQueryParams;
-	ObjectQueryParams = FCollisionObjectQueryParams(UEngineTypes::ConvertToCollisionChannel(ObjectType));
+FCollisionQueryTestResult& FCollisionQueryTestResult::GetThreadScratch()
+{
+	static thread_local FCollisionQueryTestResult Scratch;
+	return Scratch;
+}
 
-	FCollisionShape CollisionShape;
-	if (Shape == ECollisionQueryTestShape::Box)
-	{
-		CollisionShape = FCollisionShape::MakeBox(BoxHalfExtent);
-	}
-	else if (Shape == ECollisionQueryTestShape::Sphere)
-	{
-		CollisionShape = FCollisionShape::MakeSphere(SphereRadius);
-	}
-	else if (Shape == ECollisionQueryTestShape::Capsule)
+namespace CollisionQueryTestResults
+{
+	/** Counts any growth of the result's arrays during a query towards the per frame allocation stats. */
+	static void CountAllocations(const FCollisionQueryTestResult& Result, SIZE_T PrevAllocatedSize)
 	{
-		CollisionShape = FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight);
+		const SIZE_T AllocatedSize = Result.GetAllocatedSize();
+		if (AllocatedSize > PrevAllocatedSize)
+		{
+			INC_DWORD_STAT(STAT_CollisionQueryTest_ResultAllocations);
+			INC_DWORD_STAT_BY(STAT_CollisionQueryTest_ResultBytesAllocated, static_cast<uint32>(AllocatedSize - PrevAllocatedSize));
+		}
 	}
 
-	bool bResult = false;
-	FHitResult Hit;
-	TArray<FHitResult> Hits;
-	TArray<FOverlapResult> Overlaps;
-
-	if (Query == ECollisionQueryTestType::LineTrace)
+	/** Gets the call a query is reported to captures as. */
+	template<typename DescType>
+	static ECollisionQueryCaptureCall GetCaptureCall(const DescType& Desc)
 	{
-		if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		using ECall = ECollisionQueryCaptureCall;
+
+		if (Desc.Query == ECollisionQueryTestType::Overlap)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->LineTraceSingleByChannel(Hit, Start, End, Channel, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				bResult = World->LineTraceSingleByObjectType(Hit, Start, End, ObjectQueryParams, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
+			if (Desc.BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::BlockingTest)
 			{
-				bResult = World->LineTraceSingleByProfile(Hit, Start, End, CollisionProfileName, QueryParams);
+				return ECall::OverlapBlockingTest;
 			}
+			return Desc.BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::AnyTest ? ECall::OverlapAnyTest : ECall::OverlapMulti;
+		}
 
-#if ENABLE_DRAW_DEBUG
-			if (bResult)
-			{
-				DrawDebugLine(World, Start, Hit.Location, FColor::Green, false, 0.f, 0, LineThickness);
-				DrawDebugPoint(World, Hit.ImpactPoint, PointSize, FColor::Green, false, 0.f, 0);
-			}
-			else
-			{
-				DrawDebugLine(World, Start, End, FColor::Red, false, 0.f, 0, LineThickness);
-			}
-#endif // ENABLE_DRAW_DEBUG
+		const bool bSweep = Desc.Query == ECollisionQueryTestType::Sweep;
+		if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		{
+			return bSweep ? ECall::SweepSingle : ECall::LineTraceSingle;
 		}
-		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+		if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->LineTraceMultiByChannel(Hits, Start, End, Channel, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				bResult = World->LineTraceMultiByObjectType(Hits, Start, End, ObjectQueryParams, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
-			{
-				bResult = World->LineTraceMultiByProfile(Hits, Start, End, CollisionProfileName, QueryParams);
-			}
+			return bSweep ? ECall::SweepMulti : ECall::LineTraceMulti;
+		}
+		return bSweep ? ECall::SweepTest : ECall::LineTraceTest;
+	}
+}
 
-#if ENABLE_DRAW_DEBUG
-			if (bResult)
-			{
-				FVector TraceEnd = Hits.Last().Location;
-				if (By == ECollisionQueryTestBy::ObjectType)
-				{
-					TraceEnd = End; // trace by object type does not stop on first blocking hit
-				}
+#if CPUPROFILERTRACE_ENABLED
 
-				DrawDebugLine(World, Start, TraceEnd, FColor::Green, false, 0.f, 0, LineThickness);
-			}
-			else
-			{
-				DrawDebugLine(World, Start, End, Hits.Num() > 0 ? FColor::Blue : FColor::Red, false, 0.f, 0, LineThickness);
-			}
+// enable with -trace=cpu,CollisionQueryTest or Trace.Enable CollisionQueryTest
+UE_TRACE_CHANNEL_DEFINE(CollisionQueryTestChannel);
 
-			for (const FHitResult& HitResult : Hits)
-			{
-				DrawDebugPoint(World, HitResult.ImpactPoint, PointSize, HitResult.bBlockingHit ? FColor::Green : FColor::Blue, false, 0.f, 0);
-			}
-#endif // ENABLE_DRAW_DEBUG
+UE_TRACE_EVENT_BEGIN(CollisionQueryTest, Query)
+	UE_TRACE_EVENT_FIELD(uint64, StartCycle)
+	UE_TRACE_EVENT_FIELD(uint64, EndCycle)
+	UE_TRACE_EVENT_FIELD(uint8, Type)
+	UE_TRACE_EVENT_FIELD(uint8, SingleMultiOrTest)
+	UE_TRACE_EVENT_FIELD(uint8, BlockingAnyOrMulti)
+	UE_TRACE_EVENT_FIELD(uint8, By)
+	UE_TRACE_EVENT_FIELD(uint8, Channel)
+	UE_TRACE_EVENT_FIELD(uint8, Shape)
+	UE_TRACE_EVENT_FIELD(float, ExtentX)
+	UE_TRACE_EVENT_FIELD(float, ExtentY)
+	UE_TRACE_EVENT_FIELD(float, ExtentZ)
+	UE_TRACE_EVENT_FIELD(bool, bTraceComplex)
+	UE_TRACE_EVENT_FIELD(bool, bResult)
+	UE_TRACE_EVENT_FIELD(int32, NumHits)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Profile)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Actor)
+UE_TRACE_EVENT_END()
+
+namespace CollisionQueryTestTrace
+{
+	/**
+	 * Traces a query on the CollisionQueryTest channel as a CPU profiler scope named after the query and its actor, so it
+	 * can be told apart on the Insights timeline, followed by a Query event with its settings and result for analysis.
+	 */
+	class FQueryScope
+	{
+	public:
+		FQueryScope(const FCollisionQueryTestDesc& InDesc, const FCollisionQueryTestResult& InResult)
+			: Desc(InDesc)
+			, Result(InResult)
+			, bEnabled(UE_TRACE_CHANNELEXPR_IS_ENABLED(CollisionQueryTestChannel))
+			, StartCycles(FPlatformTime::Cycles64())
+			, CpuScope(bEnabled ? *GetScopeName(InDesc) : TEXT(""), CollisionQueryTestChannel, bEnabled)
+		{
 		}
-		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+
+		~FQueryScope()
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->LineTraceTestByChannel(Start, End, Channel, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				bResult = World->LineTraceTestByObjectType(Start, End, ObjectQueryParams, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
+			if (!bEnabled)
 			{
-				bResult = World->LineTraceTestByProfile(Start, End, CollisionProfileName, QueryParams);
+				return;
 			}
 
-#if ENABLE_DRAW_DEBUG
-			DrawDebugLine(World, Start, End, bResult ? FColor::Green : FColor::Red, false, 0.f, 0, LineThickness);
-#endif // ENABLE_DRAW_DEBUG
+			const FVector3f Extent(Desc.CollisionShape.GetExtent());
+			const FString Profile = Desc.CollisionProfileName.ToString();
+			const FString Actor = Desc.QueryParams.OwnerTag.ToString();
+			const int32 NumHits = FMath::Max3(Result.Hits.Num(), Result.Overlaps.Num(), Result.bResult ? 1 : 0);
+
+			UE_TRACE_LOG(CollisionQueryTest, Query, CollisionQueryTestChannel)
+				<< Query.StartCycle(StartCycles)
+				<< Query.EndCycle(FPlatformTime::Cycles64())
+				<< Query.Type(static_cast<uint8>(Desc.Query))
+				<< Query.SingleMultiOrTest(static_cast<uint8>(Desc.SingleMultiOrTest))
+				<< Query.BlockingAnyOrMulti(static_cast<uint8>(Desc.BlockingAnyOrMulti))
+				<< Query.By(static_cast<uint8>(Desc.By))
+				<< Query.Channel(static_cast<uint8>(Desc.Channel))
+				<< Query.Shape(static_cast<uint8>(Desc.CollisionShape.ShapeType))
+				<< Query.ExtentX(Extent.X)
+				<< Query.ExtentY(Extent.Y)
+				<< Query.ExtentZ(Extent.Z)
+				<< Query.bTraceComplex(Desc.QueryParams.bTraceComplex)
+				<< Query.bResult(Result.bResult)
+				<< Query.NumHits(NumHits)
+				<< Query.Profile(*Profile, Profile.Len())
+				<< Query.Actor(*Actor, Actor.Len());
 		}
+
+	private:
+		/** eg. "Sweep Multi ByChannel Capsule Complex (34x88) ECC_Pawn BP_TestActor" */
+		static FString GetScopeName(const FCollisionQueryTestDesc& Desc)
+		{
+			const FVector Extent = Desc.CollisionShape.GetExtent();
+			const FString Filter = Desc.By == ECollisionQueryTestBy::Profile ? Desc.CollisionProfileName.ToString()
+				: Desc.By == ECollisionQueryTestBy::Channel ? UEnum::GetValueAsString(Desc.Channel)
+				: FString(TEXT("ObjectType"));
+			return FString::Printf(TEXT("%s (%gx%gx%g) %s %s"), *Desc.ToString(), Extent.X, Extent.Y, Extent.Z, *Filter, *Desc.QueryParams.OwnerTag.ToString());
+		}
+
+		const FCollisionQueryTestDesc& Desc;
+		const FCollisionQueryTestResult& Result;
+		const bool bEnabled;
+		const uint64 StartCycles;
+		FCpuProfilerTrace::FDynamicEventScope CpuScope;
+	};
+}
+
+#endif // CPUPROFILERTRACE_ENABLED
+
+namespace CollisionQueryTestExecutors
+{
+	constexpr uint32 NumTypes = 3;
+	constexpr uint32 NumModes = 3;
+	constexpr uint32 NumBys = 3;
+	constexpr uint32 NumExecuteFunctions = NumTypes * NumModes * NumBys;
+
+	// overlaps are split by blocking/any/multi rather than single/multi/test, so the middle index is whichever of the two applies
+	constexpr uint32 GetIndex(ECollisionQueryTestType Query, ECollisionQueryTestSingleMultiOrTest SingleMultiOrTest, ECollisionQueryTestBlockingAnyOrMulti BlockingAnyOrMulti, ECollisionQueryTestBy By)
+	{
+		const uint32 Mode = Query == ECollisionQueryTestType::Overlap ? static_cast<uint32>(BlockingAnyOrMulti) : static_cast<uint32>(SingleMultiOrTest);
+		return (static_cast<uint32>(Query) * NumModes + Mode) * NumBys + static_cast<uint32>(By);
 	}
-	else if (Query == ECollisionQueryTestType::Sweep)
+
+	/** Makes the UWorld query for one combination of type, mode and by, with the branching on them resolved at compile time. */
+	template <uint32 Index>
+	bool Execute(const FCollisionQueryTestDesc& Desc, const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FCollisionQueryTestResult& OutResult)
 	{
-		if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		constexpr ECollisionQueryTestType Query = static_cast<ECollisionQueryTestType>(Index / (NumModes * NumBys));
+		constexpr ECollisionQueryTestSingleMultiOrTest SingleMultiOrTest = static_cast<ECollisionQueryTestSingleMultiOrTest>(Index / NumBys % NumModes);
+		constexpr ECollisionQueryTestBlockingAnyOrMulti BlockingAnyOrMulti = static_cast<ECollisionQueryTestBlockingAnyOrMulti>(Index / NumBys % NumModes);
+		constexpr ECollisionQueryTestBy By = static_cast<ECollisionQueryTestBy>(Index % NumBys);
+
+		bool bResult = false;
+
+		if constexpr (Query == ECollisionQueryTestType::LineTrace)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->SweepSingleByChannel(Hit, Start, End, Rot, Channel, CollisionShape, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				bResult = World->SweepSingleByObjectType(Hit, Start, End, Rot, ObjectQueryParams, CollisionShape, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
+			if constexpr (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
 			{
-				bResult = World->SweepSingleByProfile(Hit, Start, End, Rot, CollisionProfileName, CollisionShape, QueryParams);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->LineTraceSingleByChannel(OutResult.Hit, Start, End, Desc.Channel, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					bResult = World->LineTraceSingleByObjectType(OutResult.Hit, Start, End, Desc.ObjectQueryParams, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->LineTraceSingleByProfile(OutResult.Hit, Start, End, Desc.CollisionProfileName, Desc.QueryParams);
+				}
 			}
-
-#if ENABLE_DRAW_DEBUG
-			if (bResult)
+			else if constexpr (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
 			{
-				DrawDebugPoint(World, Hit.ImpactPoint, PointSize, FColor::Green, false, 0.f, 0);
-				DrawDebugSweptCollisionShape(World, Start, Hit.Location, Rot, CollisionShape, FColor::Green, false, 0.f, 0, LineThickness);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->LineTraceMultiByChannel(OutResult.Hits, Start, End, Desc.Channel, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					bResult = World->LineTraceMultiByObjectType(OutResult.Hits, Start, End, Desc.ObjectQueryParams, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->LineTraceMultiByProfile(OutResult.Hits, Start, End, Desc.CollisionProfileName, Desc.QueryParams);
+				}
 			}
-			else
+			else if constexpr (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
 			{
-				DrawDebugSweptCollisionShape(World, Start, End, Rot, CollisionShape, FColor::Red, false, 0.f, 0, LineThickness);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->LineTraceTestByChannel(Start, End, Desc.Channel, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					bResult = World->LineTraceTestByObjectType(Start, End, Desc.ObjectQueryParams, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->LineTraceTestByProfile(Start, End, Desc.CollisionProfileName, Desc.QueryParams);
+				}
 			}
-#endif // ENABLE_DRAW_DEBUG
 		}
-		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+		else if constexpr (Query == ECollisionQueryTestType::Sweep)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->SweepMultiByChannel(Hits, Start, End, Rot, Channel, CollisionShape, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				bResult = World->SweepMultiByObjectType(Hits, Start, End, Rot, ObjectQueryParams, CollisionShape, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
-			{
-				bResult = World->SweepMultiByProfile(Hits, Start, End, Rot, CollisionProfileName, CollisionShape, QueryParams);
-			}
-
-#if ENABLE_DRAW_DEBUG
-			if (bResult)
+			if constexpr (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
 			{
-				FVector SweepEnd = Hits.Last().Location;
-				if (By == ECollisionQueryTestBy::ObjectType)
+				if constexpr (By == ECollisionQueryTestBy::Channel)
 				{
-					SweepEnd = End; // sweep by object type does not stop on first blocking hit
+					bResult = World->SweepSingleByChannel(OutResult.Hit, Start, End, Rot, Desc.Channel, Desc.CollisionShape, Desc.QueryParams, Desc.ResponseParams);
 				}
-				else if (Hits.Last().bStartPenetrating)
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
 				{
-					SweepEnd = End; // sweeps do not stop on initial blocking overlaps
+					bResult = World->SweepSingleByObjectType(OutResult.Hit, Start, End, Rot, Desc.ObjectQueryParams, Desc.CollisionShape, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->SweepSingleByProfile(OutResult.Hit, Start, End, Rot, Desc.CollisionProfileName, Desc.CollisionShape, Desc.QueryParams);
 				}
-
-				DrawDebugSweptCollisionShape(World, Start, SweepEnd, Rot, CollisionShape, FColor::Green, false, 0.f, 0, LineThickness);
 			}
-			else
+			else if constexpr (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
 			{
-				DrawDebugSweptCollisionShape(World, Start, End, Rot, CollisionShape, Hits.Num() > 0 ? FColor::Blue : FColor::Red, false, 0.f, 0, LineThickness);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->SweepMultiByChannel(OutResult.Hits, Start, End, Rot, Desc.Channel, Desc.CollisionShape, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					bResult = World->SweepMultiByObjectType(OutResult.Hits, Start, End, Rot, Desc.ObjectQueryParams, Desc.CollisionShape, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->SweepMultiByProfile(OutResult.Hits, Start, End, Rot, Desc.CollisionProfileName, Desc.CollisionShape, Desc.QueryParams);
+				}
 			}
-
-			for (const FHitResult& HitResult : Hits)
+			else if constexpr (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
 			{
-				DrawDebugPoint(World, HitResult.ImpactPoint, PointSize, HitResult.bBlockingHit ? FColor::Green : FColor::Blue, false, 0.f, 0);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->SweepTestByChannel(Start, End, Rot, Desc.Channel, Desc.CollisionShape, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					bResult = World->SweepTestByObjectType(Start, End, Rot, Desc.ObjectQueryParams, Desc.CollisionShape, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->SweepTestByProfile(Start, End, Rot, Desc.CollisionProfileName, Desc.CollisionShape, Desc.QueryParams);
+				}
 			}
-#endif // ENABLE_DRAW_DEBUG
 		}
-		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+		else if constexpr (Query == ECollisionQueryTestType::Overlap)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
+			if constexpr (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::BlockingTest)
 			{
-				bResult = World->SweepTestByChannel(Start, End, Rot, Channel, CollisionShape, QueryParams, ResponseParams);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->OverlapBlockingTestByChannel(Start, Rot, Desc.Channel, Desc.CollisionShape, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					// NB: there is no OverlapBlockingTestByObjectType function because hits/overlaps from queries by object type are always considered blocking
+					bResult = World->OverlapAnyTestByObjectType(Start, Rot, Desc.ObjectQueryParams, Desc.CollisionShape, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->OverlapBlockingTestByProfile(Start, Rot, Desc.CollisionProfileName, Desc.CollisionShape, Desc.QueryParams);
+				}
 			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
+			else if constexpr (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::AnyTest)
 			{
-				bResult = World->SweepTestByObjectType(Start, End, Rot, ObjectQueryParams, CollisionShape, QueryParams);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->OverlapAnyTestByChannel(Start, Rot, Desc.Channel, Desc.CollisionShape, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					bResult = World->OverlapAnyTestByObjectType(Start, Rot, Desc.ObjectQueryParams, Desc.CollisionShape, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->OverlapAnyTestByProfile(Start, Rot, Desc.CollisionProfileName, Desc.CollisionShape, Desc.QueryParams);
+				}
 			}
-			else if (By == ECollisionQueryTestBy::Profile)
+			else if constexpr (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::Multi)
 			{
-				bResult = World->SweepTestByProfile(Start, End, Rot, CollisionProfileName, CollisionShape, QueryParams);
+				if constexpr (By == ECollisionQueryTestBy::Channel)
+				{
+					bResult = World->OverlapMultiByChannel(OutResult.Overlaps, Start, Rot, Desc.Channel, Desc.CollisionShape, Desc.QueryParams, Desc.ResponseParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::ObjectType)
+				{
+					bResult = World->OverlapMultiByObjectType(OutResult.Overlaps, Start, Rot, Desc.ObjectQueryParams, Desc.CollisionShape, Desc.QueryParams);
+				}
+				else if constexpr (By == ECollisionQueryTestBy::Profile)
+				{
+					bResult = World->OverlapMultiByProfile(OutResult.Overlaps, Start, Rot, Desc.CollisionProfileName, Desc.CollisionShape, Desc.QueryParams);
+				}
 			}
+		}
 
-#if ENABLE_DRAW_DEBUG
-			DrawDebugSweptCollisionShape(World, Start, End, Rot, CollisionShape, bResult ? FColor::Green : FColor::Red, false, 0.f, 0, LineThickness);
-#endif // ENABLE_DRAW_DEBUG
+		return bResult;
+	}
+
+	template <typename IndexSequence>
+	struct TExecuteFunctionTable;
+
+	template <uint32... Indices>
+	struct TExecuteFunctionTable<TIntegerSequence<uint32, Indices...>>
+	{
+		static constexpr FCollisionQueryTestDesc::FExecuteFunction Functions[] = { &Execute<Indices>... };
+	};
+
+	using FExecuteFunctionTable = TExecuteFunctionTable<TMakeIntegerSequence<uint32, NumExecuteFunctions>>;
+}
+
+void FCollisionQueryTestDesc::Prebuild()
+{
+	Executor = GetExecuteFunction();
+}
+
+FCollisionQueryTestDesc::FExecuteFunction FCollisionQueryTestDesc::GetExecuteFunction() const
+{
+	using namespace CollisionQueryTestExecutors;
+	return FExecuteFunctionTable::Functions[GetIndex(Query, SingleMultiOrTest, BlockingAnyOrMulti, By)];
+}
+
+bool FCollisionQueryTestDesc::Execute(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FCollisionQueryTestResult& OutResult) const
+{
+	OutResult.Reset();
+
+	bool& bResult = OutResult.bResult;
+
+	TStatId StatId = GET_STATID(STAT_CollisionQueryTest_LineTrace);
+	if (Query == ECollisionQueryTestType::Sweep)
+	{
+		StatId = GET_STATID(STAT_CollisionQueryTest_Sweep);
+	}
+	else if (Query == ECollisionQueryTestType::Overlap)
+	{
+		StatId = GET_STATID(STAT_CollisionQueryTest_Overlap);
+	}
+	FScopeCycleCounter CycleCounter(StatId);
+
+#if CPUPROFILERTRACE_ENABLED
+	CollisionQueryTestTrace::FQueryScope TraceScope(*this, OutResult);
+#endif
+
+	// tags everything the query allocates, including inside the physics scene, for stat LLM
+	LLM_SCOPE_BYNAME(TEXT("CollisionQueryTest"));
+	const SIZE_T PrevAllocatedSize = OutResult.GetAllocatedSize();
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	const FExecuteFunction ExecuteFunction = Executor ? Executor : GetExecuteFunction();
+	checkSlow(ExecuteFunction == GetExecuteFunction());
+	bResult = ExecuteFunction(*this, World, Start, End, Rot, OutResult);
+
+	OutResult.ExecutionTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	CollisionQueryTestResults::CountAllocations(OutResult, PrevAllocatedSize);
+	FCollisionQueryCapture::Record(CollisionQueryTestResults::GetCaptureCall(*this), QueryParams, OutResult.ExecutionTime, bResult);
+
+	return bResult;
+}
+
+FTraceHandle FCollisionQueryTestDesc::ExecuteAsync(UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FTraceDelegate* TraceDelegate, FOverlapDelegate* OverlapDelegate) const
+{
+	EAsyncTraceType TraceType = EAsyncTraceType::Single;
+	if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+	{
+		TraceType = EAsyncTraceType::Multi;
+	}
+	else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+	{
+		TraceType = EAsyncTraceType::Test;
+	}
+
+	const FVector& Pos = Start;
+
+	if (Query == ECollisionQueryTestType::LineTrace)
+	{
+		if (By == ECollisionQueryTestBy::Channel)
+		{
+			return World->AsyncLineTraceByChannel(TraceType, Start, End, Channel, QueryParams, ResponseParams, TraceDelegate);
+		}
+		else if (By == ECollisionQueryTestBy::ObjectType)
+		{
+			return World->AsyncLineTraceByObjectType(TraceType, Start, End, ObjectQueryParams, QueryParams, TraceDelegate);
+		}
+		else if (By == ECollisionQueryTestBy::Profile)
+		{
+			return World->AsyncLineTraceByProfile(TraceType, Start, End, CollisionProfileName, QueryParams, TraceDelegate);
+		}
+	}
+	else if (Query == ECollisionQueryTestType::Sweep)
+	{
+		if (By == ECollisionQueryTestBy::Channel)
+		{
+			return World->AsyncSweepByChannel(TraceType, Start, End, Rot, Channel, CollisionShape, QueryParams, ResponseParams, TraceDelegate);
+		}
+		else if (By == ECollisionQueryTestBy::ObjectType)
+		{
+			return World->AsyncSweepByObjectType(TraceType, Start, End, Rot, ObjectQueryParams, CollisionShape, QueryParams, TraceDelegate);
+		}
+		else if (By == ECollisionQueryTestBy::Profile)
+		{
+			return World->AsyncSweepByProfile(TraceType, Start, End, Rot, CollisionProfileName, CollisionShape, QueryParams, TraceDelegate);
 		}
 	}
 	else if (Query == ECollisionQueryTestType::Overlap)
 	{
-		if (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::BlockingTest)
+		// NB: async overlaps are always multi, the blocking/any tests are resolved from the results when they come back
+		if (By == ECollisionQueryTestBy::Channel)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->OverlapBlockingTestByChannel(Pos, Rot, Channel, CollisionShape, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				// NB: there is no OverlapBlockingTestByObjectType function because hits/overlaps from queries by object type are always considered blocking
-				bResult = World->OverlapAnyTestByObjectType(Pos, Rot, ObjectQueryParams, CollisionShape, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
-			{
-				bResult = World->OverlapBlockingTestByProfile(Pos, Rot, CollisionProfileName, CollisionShape, QueryParams);
-			}
+			return World->AsyncOverlapByChannel(Pos, Rot, Channel, CollisionShape, QueryParams, ResponseParams, OverlapDelegate);
 		}
-		else if (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::AnyTest)
+		else if (By == ECollisionQueryTestBy::ObjectType)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->OverlapAnyTestByChannel(Pos, Rot, Channel, CollisionShape, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				bResult = World->OverlapAnyTestByObjectType(Pos, Rot, ObjectQueryParams, CollisionShape, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
-			{
-				bResult = World->OverlapAnyTestByProfile(Pos, Rot, CollisionProfileName, CollisionShape, QueryParams);
-			}
+			return World->AsyncOverlapByObjectType(Pos, Rot, ObjectQueryParams, CollisionShape, QueryParams, OverlapDelegate);
 		}
-		else if (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::Multi)
+		else if (By == ECollisionQueryTestBy::Profile)
 		{
-			if (By == ECollisionQueryTestBy::Channel)
-			{
-				bResult = World->OverlapMultiByChannel(Overlaps, Pos, Rot, Channel, CollisionShape, QueryParams, ResponseParams);
-			}
-			else if (By == ECollisionQueryTestBy::ObjectType)
-			{
-				bResult = World->OverlapMultiByObjectType(Overlaps, Pos, Rot, ObjectQueryParams, CollisionShape, QueryParams);
-			}
-			else if (By == ECollisionQueryTestBy::Profile)
-			{
-				bResult = World->OverlapMultiByProfile(Overlaps, Pos, Rot, CollisionProfileName, CollisionShape, QueryParams);
-			}
+			return World->AsyncOverlapByProfile(Pos, Rot, CollisionProfileName, CollisionShape, QueryParams, OverlapDelegate);
 		}
-
-#if ENABLE_DRAW_DEBUG
-		DrawDebugCollisionShape(World, Pos, Rot, CollisionShape, bResult ? FColor::Green : FColor::Red, false, 0.f, 0, LineThickness);
-#endif // ENABLE_DRAW_DEBUG
 	}
+
+	return FTraceHandle();
+}
+
+FString FCollisionQueryTestDesc::ToString() const
+{
+	const UEnum* QueryEnum = StaticEnum<ECollisionQueryTestType>();
+	const UEnum* SingleMultiOrTestEnum = StaticEnum<ECollisionQueryTestSingleMultiOrTest>();
+	const UEnum* BlockingAnyOrMultiEnum = StaticEnum<ECollisionQueryTestBlockingAnyOrMulti>();
+	const UEnum* ByEnum = StaticEnum<ECollisionQueryTestBy>();
+
+	FString Result = QueryEnum->GetNameStringByValue((int64)Query);
+	Result += TEXT(" ");
+	Result += Query == ECollisionQueryTestType::Overlap
+		? BlockingAnyOrMultiEnum->GetNameStringByValue((int64)BlockingAnyOrMulti)
+		: SingleMultiOrTestEnum->GetNameStringByValue((int64)SingleMultiOrTest);
+	Result += TEXT(" By");
+	Result += ByEnum->GetNameStringByValue((int64)By);
+
+	switch (CollisionShape.ShapeType)
+	{
+	case ECollisionShape::Box: Result += TEXT(" Box"); break;
+	case ECollisionShape::Sphere: Result += TEXT(" Sphere"); break;
+	case ECollisionShape::Capsule: Result += TEXT(" Capsule"); break;
+	default: break;
+	}
+
+	Result += QueryParams.bTraceComplex ? TEXT(" Complex") : TEXT(" Simple");
+	return Result;
+}
+
+void FCollisionQueryTestDesc::GetVariants(TArray<FCollisionQueryTestDesc>& OutVariants) const
+{
+	const ECollisionQueryTestBy AllBy[] = { ECollisionQueryTestBy::Channel, ECollisionQueryTestBy::ObjectType, ECollisionQueryTestBy::Profile };
+	const bool AllTraceComplex[] = { false, true };
+
+	OutVariants.Reserve(OutVariants.Num() + 3 * UE_ARRAY_COUNT(AllBy) * UE_ARRAY_COUNT(AllTraceComplex));
+
+	for (int32 ModeIdx = 0; ModeIdx < 3; ++ModeIdx)
+	{
+		for (const ECollisionQueryTestBy VariantBy : AllBy)
+		{
+			for (const bool bVariantTraceComplex : AllTraceComplex)
+			{
+				FCollisionQueryTestDesc& Variant = OutVariants.Add_GetRef(*this);
+				if (Query == ECollisionQueryTestType::Overlap)
+				{
+					Variant.BlockingAnyOrMulti = (ECollisionQueryTestBlockingAnyOrMulti)ModeIdx;
+				}
+				else
+				{
+					Variant.SingleMultiOrTest = (ECollisionQueryTestSingleMultiOrTest)ModeIdx;
+				}
+				Variant.By = VariantBy;
+				Variant.QueryParams.bTraceComplex = bVariantTraceComplex;
+				Variant.Prebuild();
+			}
+		}
+	}
+}
+
+uint32 GetTypeHash(const FCollisionQueryTestDesc& Desc)
+{
+	uint32 Hash = GetTypeHash((uint8)Desc.Query);
+	Hash = HashCombine(Hash, GetTypeHash((uint8)Desc.SingleMultiOrTest));
+	Hash = HashCombine(Hash, GetTypeHash((uint8)Desc.BlockingAnyOrMulti));
+	Hash = HashCombine(Hash, GetTypeHash((uint8)Desc.By));
+	Hash = HashCombine(Hash, GetTypeHash((uint8)Desc.Channel));
+	Hash = HashCombine(Hash, GetTypeHash(Desc.CollisionProfileName));
+
+	Hash = HashCombine(Hash, GetTypeHash((uint8)Desc.CollisionShape.ShapeType));
+	Hash = HashCombine(Hash, GetTypeHash(Desc.CollisionShape.GetExtent()));
+
+	const FCollisionQueryParams& Params = Desc.QueryParams;
+	const uint32 ParamFlags = (Params.bTraceComplex << 0)
+		| (Params.bFindInitialOverlaps << 1)
+		| (Params.bIgnoreBlocks << 2)
+		| (Params.bIgnoreTouches << 3)
+		| (Params.bSkipNarrowPhase << 4)
+		| ((uint32)Params.MobilityType << 5);
+	Hash = HashCombine(Hash, ParamFlags);
+
+	Hash = HashCombine(Hash, FCrc::MemCrc32(Desc.ResponseParams.CollisionResponse.EnumArray, sizeof(Desc.ResponseParams.CollisionResponse.EnumArray)));
+	Hash = HashCombine(Hash, GetTypeHash(Desc.ObjectQueryParams.GetQueryBitfield()));
+
+	return Hash;
+}
+
+FCollisionQueryTestRawDesc::FCollisionQueryTestRawDesc(const FCollisionQueryTestDesc& Desc)
+	: Query(Desc.Query)
+	, SingleMultiOrTest(Desc.SingleMultiOrTest)
+	, BlockingAnyOrMulti(Desc.BlockingAnyOrMulti)
+	, Channel(Desc.Channel)
+	, CollisionShape(Desc.CollisionShape)
+	, QueryParams(Desc.QueryParams)
+	, ResponseParams(Desc.ResponseParams)
+	, ObjectQueryParams(FCollisionObjectQueryParams::DefaultObjectQueryParam)
+{
+	// these match the conversions made by the UWorld query functions before they call FPhysicsInterface
+	if (Desc.By == ECollisionQueryTestBy::ObjectType)
+	{
+		Channel = ECC_OverlapAll_Deprecated; // the default channel of the UWorld object type queries
+		ResponseParams = FCollisionResponseParams::DefaultResponseParam;
+		ObjectQueryParams = Desc.ObjectQueryParams;
+
+		// queries by object type are always blocking, see FCollisionQueryTestDesc::Execute
+		if (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::BlockingTest)
+		{
+			BlockingAnyOrMulti = ECollisionQueryTestBlockingAnyOrMulti::AnyTest;
+		}
+	}
+	else if (Desc.By == ECollisionQueryTestBy::Profile)
+	{
+		UCollisionProfile::GetChannelAndResponseParams(Desc.CollisionProfileName, Channel, ResponseParams);
+	}
+
+	if (Query == ECollisionQueryTestType::Sweep && CollisionShape.IsNearlyZero())
+	{
+		Query = ECollisionQueryTestType::LineTrace;
+	}
+}
+
+bool FCollisionQueryTestRawDesc::Execute(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FCollisionQueryTestResult& OutResult) const
+{
+	OutResult.Reset();
+
+	bool& bResult = OutResult.bResult;
+
+	LLM_SCOPE_BYNAME(TEXT("CollisionQueryTest"));
+	const SIZE_T PrevAllocatedSize = OutResult.GetAllocatedSize();
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	if (Query == ECollisionQueryTestType::LineTrace)
+	{
+		if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		{
+			bResult = FPhysicsInterface::RaycastSingle(World, OutResult.Hit, Start, End, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+		{
+			bResult = FPhysicsInterface::RaycastMulti(World, OutResult.Hits, Start, End, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+		{
+			bResult = FPhysicsInterface::RaycastTest(World, Start, End, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+	}
+	else if (Query == ECollisionQueryTestType::Sweep)
+	{
+		if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		{
+			bResult = FPhysicsInterface::GeomSweepSingle(World, CollisionShape, Rot, OutResult.Hit, Start, End, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+		{
+			bResult = FPhysicsInterface::GeomSweepMulti(World, CollisionShape, Rot, OutResult.Hits, Start, End, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+		else if (SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+		{
+			bResult = FPhysicsInterface::GeomSweepTest(World, CollisionShape, Rot, Start, End, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+	}
+	else if (Query == ECollisionQueryTestType::Overlap)
+	{
+		if (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::BlockingTest)
+		{
+			bResult = FPhysicsInterface::GeomOverlapBlockingTest(World, CollisionShape, Start, Rot, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+		else if (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::AnyTest)
+		{
+			bResult = FPhysicsInterface::GeomOverlapAnyTest(World, CollisionShape, Start, Rot, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+		else if (BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::Multi)
+		{
+			bResult = FPhysicsInterface::GeomOverlapMulti(World, CollisionShape, Start, Rot, OutResult.Overlaps, Channel, QueryParams, ResponseParams, ObjectQueryParams);
+		}
+	}
+
+	OutResult.ExecutionTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	CollisionQueryTestResults::CountAllocations(OutResult, PrevAllocatedSize);
+	FCollisionQueryCapture::Record(CollisionQueryTestResults::GetCaptureCall(*this), QueryParams, OutResult.ExecutionTime, bResult);
+
+	return bResult;
+}
+
+void FCollisionQueryTestPatternBuffer::SetNum(int32 NewNum)
+{
+	// shrinking is allowed so that the buffers keep their allocations
+	Starts.SetNum(NewNum, false);
+	Ends.SetNum(NewNum, false);
+	StopLocations.SetNum(NewNum, false);
+	ImpactPoints.SetNum(NewNum, false);
+	NumHits.SetNum(NewNum, false);
+	Results.SetNum(NewNum, false);
+	ExecutionTimes.SetNum(NewNum, false);
+}
+
+void FCollisionQueryTestVoxelGrid::Init(const FIntVector& NewDims, const FVector& NewCellSize, const FTransform& NewTransform, bool bCountOverlaps)
+{
+	Dims = NewDims;
+	CellSize = NewCellSize;
+	Transform = NewTransform;
+
+	Occupied.Init(false, Num());
+	Dirty.Init(true, Num());
+	Counts.Reset();
+	Counts.SetNumZeroed(bCountOverlaps ? Num() : 0);
+	PrimitiveBounds.Reset();
+}
+
+FVector FCollisionQueryTestVoxelGrid::GetCellCenter(int32 CellIdx) const
+{
+	const int32 X = CellIdx % Dims.X;
+	const int32 Y = (CellIdx / Dims.X) % Dims.Y;
+	const int32 Z = CellIdx / (Dims.X * Dims.Y);
+	return Transform.TransformPosition((FVector(X, Y, Z) + 0.5) * CellSize);
+}
+
+void FCollisionQueryTestVoxelGrid::MarkDirty(const FBox& WorldBounds)
+{
+	const FBox LocalBounds = WorldBounds.InverseTransformBy(Transform);
+
+	const FIntVector MinCell(
+		FMath::FloorToInt(LocalBounds.Min.X / CellSize.X),
+		FMath::FloorToInt(LocalBounds.Min.Y / CellSize.Y),
+		FMath::FloorToInt(LocalBounds.Min.Z / CellSize.Z));
+	const FIntVector MaxCell(
+		FMath::FloorToInt(LocalBounds.Max.X / CellSize.X),
+		FMath::FloorToInt(LocalBounds.Max.Y / CellSize.Y),
+		FMath::FloorToInt(LocalBounds.Max.Z / CellSize.Z));
+
+	if (MaxCell.X < 0 || MaxCell.Y < 0 || MaxCell.Z < 0 || MinCell.X >= Dims.X || MinCell.Y >= Dims.Y || MinCell.Z >= Dims.Z)
+	{
+		return;
+	}
+
+	for (int32 Z = FMath::Max(MinCell.Z, 0); Z <= FMath::Min(MaxCell.Z, Dims.Z - 1); ++Z)
+	{
+		for (int32 Y = FMath::Max(MinCell.Y, 0); Y <= FMath::Min(MaxCell.Y, Dims.Y - 1); ++Y)
+		{
+			for (int32 X = FMath::Max(MinCell.X, 0); X <= FMath::Min(MaxCell.X, Dims.X - 1); ++X)
+			{
+				Dirty[X + Dims.X * (Y + Dims.Y * Z)] = true;
+			}
+		}
+	}
+}
+
+void FCollisionQueryStressTest::Generate(int32 Seed, const FBox& Bounds, int32 NumQueries)
+{
+	FRandomStream Stream(Seed);
+
+	NumQueries = FMath::Max(NumQueries, 0);
+	Starts.SetNumUninitialized(NumQueries);
+	Ends.SetNumUninitialized(NumQueries);
+	Rots.SetNumUninitialized(NumQueries);
+
+	// each query draws from the stream in the same order, so the same seed always gives the same queries
+	for (int32 QueryIdx = 0; QueryIdx < NumQueries; ++QueryIdx)
+	{
+		Starts[QueryIdx] = Stream.RandPointInBox(Bounds);
+		Ends[QueryIdx] = Stream.RandPointInBox(Bounds);
+		const FVector Axis = Stream.GetUnitVector();
+		Rots[QueryIdx] = FQuat(Axis, Stream.FRandRange(0.f, 2.f * PI));
+	}
+}
+
+FCollisionQueryStressTestResult FCollisionQueryStressTest::Run(const UWorld* World, const FCollisionQueryTestDesc& Desc, int32 NumThreads)
+{
+	const int32 NumQueries = Starts.Num();
+	NumThreads = FMath::Clamp(NumThreads, 1, FMath::Max(NumQueries, 1));
+
+	ExecutionTimes.SetNumUninitialized(NumQueries);
+	Results.SetNumUninitialized(NumQueries);
+
+	TArray<uint32, TInlineAllocator<64>> ShareThreadIds;
+	ShareThreadIds.SetNumZeroed(NumThreads);
+
+	auto RunShare = [this, World, &Desc, &ShareThreadIds, NumQueries, NumThreads](int32 ThreadIdx)
+	{
+		ShareThreadIds[ThreadIdx] = FPlatformTLS::GetCurrentThreadId();
+
+		FCollisionQueryTestResult& Result = FCollisionQueryTestResult::GetThreadScratch();
+
+		const int32 FirstQuery = NumQueries * ThreadIdx / NumThreads;
+		const int32 EndQuery = NumQueries * (ThreadIdx + 1) / NumThreads;
+		for (int32 QueryIdx = FirstQuery; QueryIdx < EndQuery; ++QueryIdx)
+		{
+			Desc.Execute(World, Starts[QueryIdx], Ends[QueryIdx], Rots[QueryIdx], Result);
+			ExecutionTimes[QueryIdx] = Result.ExecutionTime;
+			Results[QueryIdx] = Result.bResult;
+		}
+	};
+
+	// one share per thread. ParallelFor runs the shares on whichever workers are free and the calling thread picks up any
+	// that none of them took, so a busy task graph makes the run less parallel rather than stalling it
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	ParallelFor(NumThreads, RunShare, NumThreads > 1 ? EParallelForFlags::Unbalanced : EParallelForFlags::ForceSingleThread);
+
+	FCollisionQueryStressTestResult Result;
+	Result.NumThreads = NumThreads;
+	Result.NumQueries = NumQueries;
+	ShareThreadIds.Sort();
+	for (int32 ShareIdx = 0; ShareIdx < ShareThreadIds.Num(); ++ShareIdx)
+	{
+		Result.NumThreadsRan += ShareIdx == 0 || ShareThreadIds[ShareIdx] != ShareThreadIds[ShareIdx - 1] ? 1 : 0;
+	}
+	Result.WallTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	Result.QueriesPerSecond = Result.WallTime > 0.0 ? NumQueries / Result.WallTime : 0.0;
+	for (const bool bResult : Results)
+	{
+		Result.NumHits += bResult ? 1 : 0;
+	}
+	Result.Latency = FCollisionQueryLatencyHistory::Summarize(ExecutionTimes);
+
+	return Result;
+}
+
+void FCollisionQueryStressTest::GetThreadCounts(int32 MaxThreads, TArray<int32>& OutThreadCounts)
+{
+	const int32 NumAvailable = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	MaxThreads = MaxThreads > 0 ? FMath::Min(MaxThreads, NumAvailable) : NumAvailable;
+
+	OutThreadCounts.Reset();
+	for (int32 NumThreads = 1; NumThreads < MaxThreads; NumThreads *= 2)
+	{
+		OutThreadCounts.Add(NumThreads);
+	}
+	OutThreadCounts.Add(MaxThreads);
+}
+
+void ACollisionQueryTestActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UpdateQueryDesc();
+
+	if (UCollisionQueryTestSubsystem* Subsystem = GetWorld()->GetSubsystem<UCollisionQueryTestSubsystem>())
+	{
+		Subsystem->RegisterActor(this);
+	}
+}
+
+void ACollisionQueryTestActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCollisionQueryTestSubsystem* Subsystem = GetWorld()->GetSubsystem<UCollisionQueryTestSubsystem>())
+	{
+		Subsystem->UnregisterActor(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACollisionQueryTestActor::Tick(float DeltaSeconds)
+{
+	UWorld* World = GetWorld();
+
+	const FVector Start = GetActorLocation();
+	const FVector End = EndComponent->GetComponentLocation();
+	const FQuat Rot = GetActorQuat();
+
+	const FCollisionQueryTestDesc& Desc = QueryDesc;
+
+	LatencyHistory.SetMaxSamples(LatencySampleCount);
+
+	switch (GetTickMode())
+	{
+	case ECollisionQueryTestTickMode::Async:
+	{
+		// the result is drawn by OnAsyncTraceCompleted / OnAsyncOverlapCompleted
+		SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_AsyncIssue);
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Desc.ExecuteAsync(World, Start, End, Rot, &AsyncTraceDelegate, &AsyncOverlapDelegate);
+		LatencyHistory.AddSample(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles));
+		break;
+	}
+	case ECollisionQueryTestTickMode::Path:
+		TickPath(Desc, Rot);
+		break;
+	case ECollisionQueryTestTickMode::Compare:
+		TickCompare(Desc, Start, End, Rot);
+		break;
+	case ECollisionQueryTestTickMode::PhaseBreakdown:
+		TickPhaseBreakdown(Desc, Start, End, Rot);
+		break;
+	case ECollisionQueryTestTickMode::Traversal:
+		TickTraversal(Desc, Start, End, Rot);
+		break;
+	case ECollisionQueryTestTickMode::RawCompare:
+		TickRawCompare(Desc, Start, End, Rot);
+		break;
+	case ECollisionQueryTestTickMode::StressTest:
+		TickStressTest(Desc, Start);
+		break;
+	case ECollisionQueryTestTickMode::Heatmap:
+		TickHeatmap(Desc, Start, Rot);
+		break;
+	case ECollisionQueryTestTickMode::Pattern:
+		TickPattern(Desc, Start, End, Rot);
+		break;
+	case ECollisionQueryTestTickMode::Single:
+	{
+		uint32 QueryHash = GetTypeHash(Desc);
+		QueryHash = HashCombine(QueryHash, GetTypeHash(Start));
+		QueryHash = HashCombine(QueryHash, GetTypeHash(End));
+		QueryHash = HashCombine(QueryHash, FCrc::MemCrc32(&Rot, sizeof(Rot)));
+
+		if (CanReuseCachedResult(Desc, QueryHash, Start, End))
+		{
+			INC_DWORD_STAT(STAT_CollisionQueryTest_CachedResultsReused);
+		}
+		else
+		{
+			Desc.Execute(World, Start, End, Rot, QueryResult);
+			LatencyHistory.AddSample(QueryResult.ExecutionTime);
+
+			if (UCollisionQueryTestSubsystem* Subsystem = World->GetSubsystem<UCollisionQueryTestSubsystem>())
+			{
+				Subsystem->RecordQuery(this, Desc, Start, End, Rot, QueryResult);
+			}
+
+			QueryResultHash = QueryHash;
+			QueryResultTime = World->GetTimeSeconds();
+			bHasQueryResult = true;
+
+			if (ShouldDiffHits(Desc))
+			{
+				UpdateHitSet(Desc, QueryResult);
+			}
+		}
+
+		DrawQueryResult(Desc, Start, End, Rot, QueryResult, !ShouldDiffHits(Desc));
+		break;
+	}
+	}
+
+	DrawLatencyStats(Desc);
+	FlushDebugLines();
+}
+
+ECollisionQueryTestTickMode ACollisionQueryTestActor::GetTickMode() const
+{
+	if (bAsync)
+	{
+		return ECollisionQueryTestTickMode::Async;
+	}
+	else if (bSweepAlongPath && Query != ECollisionQueryTestType::Overlap)
+	{
+		return ECollisionQueryTestTickMode::Path;
+	}
+	else if (bCompare)
+	{
+		return ECollisionQueryTestTickMode::Compare;
+	}
+	else if (bPhaseBreakdown)
+	{
+		return ECollisionQueryTestTickMode::PhaseBreakdown;
+	}
+	else if (bTraversal)
+	{
+		return ECollisionQueryTestTickMode::Traversal;
+	}
+	else if (bRawCompare)
+	{
+		return ECollisionQueryTestTickMode::RawCompare;
+	}
+	else if (bStressTest)
+	{
+		return ECollisionQueryTestTickMode::StressTest;
+	}
+	else if (bHeatmap && Query == ECollisionQueryTestType::Overlap)
+	{
+		return ECollisionQueryTestTickMode::Heatmap;
+	}
+	else if (Pattern != ECollisionQueryTestPattern::None)
+	{
+		return ECollisionQueryTestTickMode::Pattern;
+	}
+
+	return ECollisionQueryTestTickMode::Single;
+}
+
+bool ACollisionQueryTestActor::CanTickInSubsystem() const
+{
+	// cached results are cheap enough to stay on the actor's tick
+	return GetTickMode() == ECollisionQueryTestTickMode::Single && !bCacheResult;
+}
+
+void ACollisionQueryTestActor::ReceiveBatchedResult(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result, bool bNewResult, float ResultAge)
+{
+	LatencyHistory.SetMaxSamples(LatencySampleCount);
+	if (bNewResult)
+	{
+		LatencyHistory.AddSample(Result.ExecutionTime);
+
+		if (ShouldDiffHits(Desc))
+		{
+			UpdateHitSet(Desc, Result);
+		}
+	}
+
+	const int32 FirstLine = DebugLines.Num();
+	DrawQueryResult(Desc, Start, End, Rot, Result, !ShouldDiffHits(Desc));
+	if (!bNewResult)
+	{
+		FadeDebugLines(FirstLine, ResultAge);
+	}
+
+	DrawLatencyStats(Desc);
+	FlushDebugLines();
+}
+
+FCollisionQueryTestDesc ACollisionQueryTestActor::MakeQueryDesc() const
+{
+	FCollisionQueryTestDesc Desc;
+	Desc.Query = Query;
+	Desc.SingleMultiOrTest = SingleMultiOrTest;
+	Desc.BlockingAnyOrMulti = BlockingAnyOrMulti;
+	Desc.By = By;
+	Desc.Channel = Channel;
+	Desc.CollisionProfileName = CollisionProfileName;
+
+	Desc.QueryParams.bTraceComplex = bTraceComplex;
+	Desc.QueryParams.bFindInitialOverlaps = bFindInitialOverlaps;
+	Desc.QueryParams.bIgnoreBlocks = bIgnoreBlocks;
+	Desc.QueryParams.bIgnoreTouches = bIgnoreTouches;
+	Desc.QueryParams.bSkipNarrowPhase = bSkipNarrowPhase;
+	Desc.QueryParams.MobilityType = ConvertToQueryMobilityType(MobilityType);
+	Desc.QueryParams.TraceTag = TraceTag;
+	Desc.QueryParams.OwnerTag = GetFName();
+
+	Desc.ResponseParams.CollisionResponse = CollisionResponses;
+
+	Desc.ObjectQueryParams = FCollisionObjectQueryParams(UEngineTypes::ConvertToCollisionChannel(ObjectType));
+
+	if (Query == ECollisionQueryTestType::LineTrace)
+	{
+		Desc.CollisionShape = FCollisionShape::LineShape;
+	}
+	else if (Shape == ECollisionQueryTestShape::Box)
+	{
+		Desc.CollisionShape = FCollisionShape::MakeBox(BoxHalfExtent);
+	}
+	else if (Shape == ECollisionQueryTestShape::Sphere)
+	{
+		Desc.CollisionShape = FCollisionShape::MakeSphere(SphereRadius);
+	}
+	else if (Shape == ECollisionQueryTestShape::Capsule)
+	{
+		Desc.CollisionShape = FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight);
+	}
+
+	Desc.Prebuild();
+
+	return Desc;
+}
+
+void ACollisionQueryTestActor::UpdateQueryDesc()
+{
+	QueryDesc = MakeQueryDesc();
+}
+
+bool ACollisionQueryTestActor::ShouldDiffHits(const FCollisionQueryTestDesc& Desc) const
+{
+	if (!bDiffHits)
+	{
+		return false;
+	}
+	if (Desc.Query == ECollisionQueryTestType::Overlap)
+	{
+		return Desc.BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::Multi;
+	}
+	return Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi;
+}
+
+void ACollisionQueryTestActor::UpdateHitSet(const FCollisionQueryTestDesc& Desc, const FCollisionQueryTestResult& Result)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_HitSetDiff);
+
+	const bool bOverlap = Desc.Query == ECollisionQueryTestType::Overlap;
+	if (bOverlap)
+	{
+		HitSet.Update(Result.Overlaps, DiffTolerance);
+	}
+	else
+	{
+		HitSet.Update(Result.Hits, DiffTolerance);
+	}
+
+	const TConstArrayView<FCollisionQueryHitChange> Changes = HitSet.GetChanges();
+	if (Changes.Num() == 0)
+	{
+		return;
+	}
+
+#if ENABLE_DRAW_DEBUG
+	// every entry owns a fixed run of retained lines at its slot: a point and its normal for hits, the bounds of the
+	// component for overlaps. Removed entries have their lines collapsed to nothing
+	const float PointSize = 16.f;
+	const float NormalLength = 20.f;
+	const int32 LinesPerSlot = bOverlap ? 12 : 4;
+#endif
+
+	for (const FCollisionQueryHitChange& Change : Changes)
+	{
+		const FCollisionQueryHitSetEntry& Entry = Change.Entry;
+
+		switch (Change.Type)
+		{
+		case ECollisionQueryHitChangeType::Added:
+			INC_DWORD_STAT(STAT_CollisionQueryTest_HitsAdded);
+			break;
+		case ECollisionQueryHitChangeType::Removed:
+			INC_DWORD_STAT(STAT_CollisionQueryTest_HitsRemoved);
+			break;
+		case ECollisionQueryHitChangeType::Changed:
+			INC_DWORD_STAT(STAT_CollisionQueryTest_HitsChanged);
+			break;
+		}
+
+#if ENABLE_DRAW_DEBUG
+		HitSetLines.Reset();
+		if (Change.Type != ECollisionQueryHitChangeType::Removed)
+		{
+			const FColor Color = Entry.bBlocking ? FColor::Green : FColor::Blue;
+			if (bOverlap)
+			{
+				DrawDebugCollisionShape(HitSetLines, Entry.Location, FQuat::Identity, FCollisionShape::MakeBox(Entry.Extent), Color);
+			}
+			else
+			{
+				const float HalfSize = PointSize * 0.5f;
+				DrawDebugLine(HitSetLines, Entry.Location - FVector(HalfSize, 0.f, 0.f), Entry.Location + FVector(HalfSize, 0.f, 0.f), Color);
+				DrawDebugLine(HitSetLines, Entry.Location - FVector(0.f, HalfSize, 0.f), Entry.Location + FVector(0.f, HalfSize, 0.f), Color);
+				DrawDebugLine(HitSetLines, Entry.Location - FVector(0.f, 0.f, HalfSize), Entry.Location + FVector(0.f, 0.f, HalfSize), Color);
+				DrawDebugLine(HitSetLines, Entry.Location, Entry.Location + Entry.Normal * NormalLength, Color);
+			}
+		}
+		check(HitSetLines.Num() <= LinesPerSlot);
+
+		for (int32 LineIdx = 0; LineIdx < LinesPerSlot; ++LineIdx)
+		{
+			const int32 RetainedLineIdx = Entry.Slot * LinesPerSlot + LineIdx;
+			if (HitSetLines.IsValidIndex(LineIdx))
+			{
+				const FBatchedLine& Line = HitSetLines[LineIdx];
+				ResultComponent->SetRetainedLine(RetainedLineIdx, Line.Start, Line.End, Line.Color.ToFColor(true));
+			}
+			else
+			{
+				ResultComponent->SetRetainedLine(RetainedLineIdx, Entry.Location, Entry.Location, FColor::Transparent);
+			}
+		}
+#endif // ENABLE_DRAW_DEBUG
+	}
+
+	OnHitSetChanged.Broadcast(this, Changes);
+}
+
+void ACollisionQueryTestActor::ResetHitSet()
+{
+	HitSet.Reset();
+	ResultComponent->ClearRetainedLines();
+}
+
+void ACollisionQueryTestActor::DrawQueryResult(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result, bool bDrawHits) const
+{
+#if ENABLE_DRAW_DEBUG
+	const float LineThickness = 0.f;
+	const float PointSize = 16.f;
+
+	const UWorld* World = GetWorld();
+	const FCollisionQueryDebugDrawView& DrawView = FCollisionQueryDebugDrawView::Get(World);
+
+	const bool bResult = Result.bResult;
+	const FHitResult& Hit = Result.Hit;
+	const TArray<FHitResult>& Hits = Result.Hits;
+
+	const FVector& Pos = Start;
+	const FCollisionShape& CollisionShape = Desc.CollisionShape;
+
+	if (Desc.Query == ECollisionQueryTestType::LineTrace)
+	{
+		if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		{
+			if (bResult)
+			{
+				DrawDebugLine(DebugLines, Start, Hit.Location, FColor::Green, 0, LineThickness);
+				DrawHitPoint(Hit.ImpactPoint, PointSize, FColor::Green);
+			}
+			else
+			{
+				DrawDebugLine(DebugLines, Start, End, FColor::Red, 0, LineThickness);
+			}
+		}
+		else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+		{
+			if (bResult)
+			{
+				FVector TraceEnd = Hits.Last().Location;
+				if (Desc.By == ECollisionQueryTestBy::ObjectType)
+				{
+					TraceEnd = End; // trace by object type does not stop on first blocking hit
+				}
+
+				DrawDebugLine(DebugLines, Start, TraceEnd, FColor::Green, 0, LineThickness);
+			}
+			else
+			{
+				DrawDebugLine(DebugLines, Start, End, Hits.Num() > 0 ? FColor::Blue : FColor::Red, 0, LineThickness);
+			}
+
+			if (bDrawHits)
+			{
+				for (const FHitResult& HitResult : Hits)
+				{
+					DrawHitPoint(HitResult.ImpactPoint, PointSize, HitResult.bBlockingHit ? FColor::Green : FColor::Blue);
+				}
+			}
+		}
+		else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+		{
+			DrawDebugLine(DebugLines, Start, End, bResult ? FColor::Green : FColor::Red, 0, LineThickness);
+		}
+	}
+	else if (Desc.Query == ECollisionQueryTestType::Sweep)
+	{
+		if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		{
+			if (bResult)
+			{
+				DrawHitPoint(Hit.ImpactPoint, PointSize, FColor::Green);
+				DrawDebugSweptCollisionShape(DebugLines, DrawView, Start, Hit.Location, Rot, CollisionShape, FColor::Green, 0, LineThickness);
+			}
+			else
+			{
+				DrawDebugSweptCollisionShape(DebugLines, DrawView, Start, End, Rot, CollisionShape, FColor::Red, 0, LineThickness);
+			}
+		}
+		else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+		{
+			if (bResult)
+			{
+				FVector SweepEnd = Hits.Last().Location;
+				if (Desc.By == ECollisionQueryTestBy::ObjectType)
+				{
+					SweepEnd = End; // sweep by object type does not stop on first blocking hit
+				}
+				else if (Hits.Last().bStartPenetrating)
+				{
+					SweepEnd = End; // sweeps do not stop on initial blocking overlaps
+				}
+
+				DrawDebugSweptCollisionShape(DebugLines, DrawView, Start, SweepEnd, Rot, CollisionShape, FColor::Green, 0, LineThickness);
+			}
+			else
+			{
+				DrawDebugSweptCollisionShape(DebugLines, DrawView, Start, End, Rot, CollisionShape, Hits.Num() > 0 ? FColor::Blue : FColor::Red, 0, LineThickness);
+			}
+
+			if (bDrawHits)
+			{
+				for (const FHitResult& HitResult : Hits)
+				{
+					DrawHitPoint(HitResult.ImpactPoint, PointSize, HitResult.bBlockingHit ? FColor::Green : FColor::Blue);
+				}
+			}
+		}
+		else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+		{
+			DrawDebugSweptCollisionShape(DebugLines, DrawView, Start, End, Rot, CollisionShape, bResult ? FColor::Green : FColor::Red, 0, LineThickness);
+		}
+	}
+	else if (Desc.Query == ECollisionQueryTestType::Overlap)
+	{
+		DrawDebugCollisionShape(DebugLines, DrawView, Pos, Rot, CollisionShape, bResult ? FColor::Green : FColor::Red, 0, LineThickness);
+	}
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::TickPattern(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_Pattern);
+
+	BuildPattern(Start, End);
+
+	const UWorld* World = GetWorld();
+	FCollisionQueryTestPatternBuffer& Buffer = PatternBuffer;
+
+	ParallelFor(Buffer.Num(), [this, &Desc, &Buffer, World, &Rot](int32 QueryIdx)
+	{
+		const FVector& QueryStart = Buffer.Starts[QueryIdx];
+		const FVector& QueryEnd = Buffer.Ends[QueryIdx];
+
+		FCollisionQueryTestResult& Result = FCollisionQueryTestResult::GetThreadScratch();
+		if (Desc.Query == ECollisionQueryTestType::Overlap)
+		{
+			const FVector& Pos = GetPatternOverlapPos(QueryIdx);
+			Desc.Execute(World, Pos, Pos, Rot, Result);
+		}
+		else
+		{
+			Desc.Execute(World, QueryStart, QueryEnd, Rot, Result);
+		}
+
+		FVector StopLocation = QueryEnd;
+		FVector ImpactPoint = QueryEnd;
+		int32 NumHits = Result.bResult ? 1 : 0;
+
+		if (Result.bResult && Desc.Query != ECollisionQueryTestType::Overlap && Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		{
+			StopLocation = Result.Hit.Location;
+			ImpactPoint = Result.Hit.ImpactPoint;
+		}
+		else if (Result.Hits.Num() > 0)
+		{
+			const FHitResult& LastHit = Result.Hits.Last();
+			ImpactPoint = LastHit.ImpactPoint;
+			NumHits = Result.Hits.Num();
+
+			// queries by object type do not stop on the first blocking hit, and sweeps do not stop on initial blocking overlaps
+			if (Result.bResult && Desc.By != ECollisionQueryTestBy::ObjectType && !LastHit.bStartPenetrating)
+			{
+				StopLocation = LastHit.Location;
+			}
+		}
+		else if (Result.Overlaps.Num() > 0)
+		{
+			NumHits = Result.Overlaps.Num();
+		}
+
+		Buffer.StopLocations[QueryIdx] = StopLocation;
+		Buffer.ImpactPoints[QueryIdx] = ImpactPoint;
+		Buffer.NumHits[QueryIdx] = NumHits;
+		Buffer.Results[QueryIdx] = Result.bResult;
+		Buffer.ExecutionTimes[QueryIdx] = Result.ExecutionTime;
+	}, bPatternParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	for (const double ExecutionTime : Buffer.ExecutionTimes)
+	{
+		LatencyHistory.AddSample(ExecutionTime);
+	}
+
+	DrawPattern(Desc, Rot);
+}
+
+void ACollisionQueryTestActor::BuildPattern(const FVector& Start, const FVector& End)
+{
+	const int32 NumX = FMath::Max(PatternCountX, 1);
+	const int32 NumY = FMath::Max(PatternCountY, 1);
+	PatternBuffer.SetNum(NumX * NumY);
+
+	const FVector TraceVec = End - Start;
+	const float Length = TraceVec.Size();
+
+	// NB: the pattern is oriented around the query direction, falling back to the actor's rotation for zero length queries
+	const FMatrix Basis = Length > UE_KINDA_SMALL_NUMBER ? FRotationMatrix::MakeFromX(TraceVec) : FRotationMatrix(GetActorRotation());
+	const FVector Forward = Basis.GetUnitAxis(EAxis::X);
+	const FVector Right = Basis.GetUnitAxis(EAxis::Y);
+	const FVector Up = Basis.GetUnitAxis(EAxis::Z);
+
+	for (int32 X = 0; X < NumX; ++X)
+	{
+		for (int32 Y = 0; Y < NumY; ++Y)
+		{
+			const int32 QueryIdx = X * NumY + Y;
+			FVector& QueryStart = PatternBuffer.Starts[QueryIdx];
+			FVector& QueryEnd = PatternBuffer.Ends[QueryIdx];
+
+			switch (Pattern)
+			{
+			case ECollisionQueryTestPattern::Grid:
+			{
+				const FVector Offset = Right * ((X - (NumX - 1) * 0.5f) * PatternSpacing) + Up * ((Y - (NumY - 1) * 0.5f) * PatternSpacing);
+				QueryStart = Start + Offset;
+				QueryEnd = End + Offset;
+				break;
+			}
+			case ECollisionQueryTestPattern::Cone:
+			case ECollisionQueryTestPattern::Hemisphere:
+			{
+				// X steps away from the query direction, Y steps around it
+				const float MaxAngle = Pattern == ECollisionQueryTestPattern::Cone ? FMath::DegreesToRadians(PatternConeAngle) : UE_HALF_PI;
+				const float Polar = MaxAngle * (X + 1) / NumX;
+				const float Azimuth = UE_TWO_PI * Y / NumY;
+
+				float SinPolar, CosPolar, SinAzimuth, CosAzimuth;
+				FMath::SinCos(&SinPolar, &CosPolar, Polar);
+				FMath::SinCos(&SinAzimuth, &CosAzimuth, Azimuth);
+
+				const FVector Dir = Forward * CosPolar + (Right * CosAzimuth + Up * SinAzimuth) * SinPolar;
+				QueryStart = Start;
+				QueryEnd = Start + Dir * Length;
+				break;
+			}
+			case ECollisionQueryTestPattern::Ring:
+			{
+				// X steps out from the query, Y steps around it
+				const float Radius = PatternSpacing * (X + 1);
+				const float Azimuth = UE_TWO_PI * Y / NumY;
+
+				float SinAzimuth, CosAzimuth;
+				FMath::SinCos(&SinAzimuth, &CosAzimuth, Azimuth);
+
+				const FVector Offset = (Right * CosAzimuth + Up * SinAzimuth) * Radius;
+				QueryStart = Start + Offset;
+				QueryEnd = End + Offset;
+				break;
+			}
+			default:
+				QueryStart = Start;
+				QueryEnd = End;
+				break;
+			}
+		}
+	}
+}
+
+const FVector& ACollisionQueryTestActor::GetPatternOverlapPos(int32 QueryIdx) const
+{
+	// overlaps are made around the start like the single query, except for patterns which spread out from the start, where
+	// the end of each query is the point in the spread
+	const bool bSpread = Pattern == ECollisionQueryTestPattern::Cone || Pattern == ECollisionQueryTestPattern::Hemisphere;
+	return bSpread ? PatternBuffer.Ends[QueryIdx] : PatternBuffer.Starts[QueryIdx];
+}
+
+void ACollisionQueryTestActor::DrawPattern(const FCollisionQueryTestDesc& Desc, const FQuat& Rot) const
+{
+#if ENABLE_DRAW_DEBUG
+	const float LineThickness = 0.f;
+	const float PointSize = 8.f;
+
+	const UWorld* World = GetWorld();
+	const FCollisionQueryDebugDrawView& DrawView = FCollisionQueryDebugDrawView::Get(World);
+	const FCollisionQueryTestPatternBuffer& Buffer = PatternBuffer;
+
+	for (int32 QueryIdx = 0; QueryIdx < Buffer.Num(); ++QueryIdx)
+	{
+		const bool bResult = Buffer.Results[QueryIdx];
+		const FColor Color = bResult ? FColor::Green : (Buffer.NumHits[QueryIdx] > 0 ? FColor::Blue : FColor::Red);
+
+		if (Desc.Query == ECollisionQueryTestType::Overlap)
+		{
+			DrawDebugCollisionShape(DebugLines, DrawView, GetPatternOverlapPos(QueryIdx), Rot, Desc.CollisionShape, Color, 0, LineThickness);
+			continue;
+		}
+
+		const FVector& QueryStart = Buffer.Starts[QueryIdx];
+		const FVector& QueryEnd = Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test ? Buffer.Ends[QueryIdx] : Buffer.StopLocations[QueryIdx];
+
+		if (Desc.Query == ECollisionQueryTestType::LineTrace)
+		{
+			DrawDebugLine(DebugLines, QueryStart, QueryEnd, Color, 0, LineThickness);
+		}
+		else
+		{
+			DrawDebugSweptCollisionShape(DebugLines, DrawView, QueryStart, QueryEnd, Rot, Desc.CollisionShape, Color, 0, LineThickness);
+		}
+
+		if (Buffer.NumHits[QueryIdx] > 0 && Desc.SingleMultiOrTest != ECollisionQueryTestSingleMultiOrTest::Test)
+		{
+			DrawHitPoint(Buffer.ImpactPoints[QueryIdx], PointSize, Color);
+		}
+	}
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::TickPath(const FCollisionQueryTestDesc& Desc, const FQuat& Rot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_Path);
+
+	const int32 NumSegments = FMath::Max(PathSegments, 1);
+	const float PathLength = PathComponent->GetSplineLength();
+
+	PathPoints.SetNum(NumSegments + 1, false);
+	for (int32 PointIdx = 0; PointIdx <= NumSegments; ++PointIdx)
+	{
+		PathPoints[PointIdx] = PathComponent->GetLocationAtDistanceAlongSpline(PathLength * PointIdx / NumSegments, ESplineCoordinateSpace::World);
+	}
+
+	PathResults.SetNum(NumSegments);
+
+	const UWorld* World = GetWorld();
+	int32 NumQueried = 0;
+	double PathTime = 0.0;
+
+	if (bPathBatched)
+	{
+		const TArray<FVector>& Points = PathPoints;
+		TArray<FCollisionQueryTestResult>& Results = PathResults;
+
+		ParallelFor(NumSegments, [&Desc, &Points, &Results, World, &Rot](int32 SegmentIdx)
+		{
+			Desc.Execute(World, Points[SegmentIdx], Points[SegmentIdx + 1], Rot, Results[SegmentIdx]);
+		});
+
+		for (const FCollisionQueryTestResult& Result : PathResults)
+		{
+			PathTime += Result.ExecutionTime;
+		}
+
+		// only the segments up to the first hit are part of the result
+		const int32 FirstHitIdx = PathResults.IndexOfByPredicate([](const FCollisionQueryTestResult& Result) { return Result.bResult; });
+		NumQueried = FirstHitIdx != INDEX_NONE ? FirstHitIdx + 1 : NumSegments;
+	}
+	else
+	{
+		for (int32 SegmentIdx = 0; SegmentIdx < NumSegments; ++SegmentIdx)
+		{
+			FCollisionQueryTestResult& Result = PathResults[SegmentIdx];
+			Desc.Execute(World, PathPoints[SegmentIdx], PathPoints[SegmentIdx + 1], Rot, Result);
+			PathTime += Result.ExecutionTime;
+			++NumQueried;
+
+			if (Result.bResult)
+			{
+				break;
+			}
+		}
+	}
+
+	LatencyHistory.AddSample(PathTime);
+
+	DrawPath(Desc, Rot, NumQueried, PathTime);
+}
+
+void ACollisionQueryTestActor::DrawPath(const FCollisionQueryTestDesc& Desc, const FQuat& Rot, int32 NumQueried, double PathTime) const
+{
+#if ENABLE_DRAW_DEBUG
+	const float LineThickness = 0.f;
+
+	for (int32 SegmentIdx = 0; SegmentIdx < NumQueried; ++SegmentIdx)
+	{
+		DrawQueryResult(Desc, PathPoints[SegmentIdx], PathPoints[SegmentIdx + 1], Rot, PathResults[SegmentIdx]);
+	}
+
+	// the rest of the path is not reached
+	for (int32 SegmentIdx = NumQueried; SegmentIdx < PathResults.Num(); ++SegmentIdx)
+	{
+		DrawDebugLine(DebugLines, PathPoints[SegmentIdx], PathPoints[SegmentIdx + 1], FColor::Silver, 0, LineThickness);
+	}
+
+	const FString Text = FString::Printf(TEXT("Path: %d of %d segments, %.2fus"), NumQueried, PathResults.Num(), PathTime * 1e6);
+	DrawDebugString(GetWorld(), GetActorLocation() + FVector(0.f, 0.f, 40.f), Text, nullptr, FColor::White, 0.f, true);
+#endif // ENABLE_DRAW_DEBUG
+}
+
+namespace CollisionQueryTestResults
+{
+	/**
+	 * Gets where the scene query stopped traversing: at the blocking hit of a single or multi trace or sweep, otherwise
+	 * at End. Test queries give no hit to clip at, so their traversal covers the whole query.
+	 */
+	static FVector GetTraversalEnd(const FCollisionQueryTestDesc& Desc, const FCollisionQueryTestResult& Result, const FVector& Start, const FVector& End)
+	{
+		if (Desc.Query == ECollisionQueryTestType::Overlap)
+		{
+			return End;
+		}
+
+		const FHitResult* BlockingHit = nullptr;
+		if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single && Result.Hit.bBlockingHit)
+		{
+			BlockingHit = &Result.Hit;
+		}
+		else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi && Result.Hits.Num() > 0 && Result.Hits.Last().bBlockingHit)
+		{
+			BlockingHit = &Result.Hits.Last();
+		}
+
+		return BlockingHit ? FMath::Lerp(Start, End, BlockingHit->Time) : End;
+	}
+
+	/** Gets the components a query hit or overlapped. Returns false if the query does not report what it hit. */
+	static bool GetHitComponents(const FCollisionQueryTestDesc& Desc, const FCollisionQueryTestResult& Result, TSet<FObjectKey>& OutComponents)
+	{
+		OutComponents.Reset();
+
+		if (Desc.Query == ECollisionQueryTestType::Overlap)
+		{
+			if (Desc.BlockingAnyOrMulti != ECollisionQueryTestBlockingAnyOrMulti::Multi)
+			{
+				return false;
+			}
+			for (const FOverlapResult& Overlap : Result.Overlaps)
+			{
+				OutComponents.Add(Overlap.GetComponent());
+			}
+		}
+		else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+		{
+			if (Result.bResult)
+			{
+				OutComponents.Add(Result.Hit.GetComponent());
+			}
+		}
+		else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+		{
+			for (const FHitResult& Hit : Result.Hits)
+			{
+				OutComponents.Add(Hit.GetComponent());
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	/** Describes how two results of the same query differ, or returns an empty string if they match. */
+	static FString DescribeDifference(const FCollisionQueryTestResult& A, const FCollisionQueryTestResult& B)
+	{
+		if (A.bResult != B.bResult)
+		{
+			return FString::Printf(TEXT("result %d vs %d"), A.bResult ? 1 : 0, B.bResult ? 1 : 0);
+		}
+		if (A.Hits.Num() != B.Hits.Num())
+		{
+			return FString::Printf(TEXT("%d vs %d hits"), A.Hits.Num(), B.Hits.Num());
+		}
+		if (A.Overlaps.Num() != B.Overlaps.Num())
+		{
+			return FString::Printf(TEXT("%d vs %d overlaps"), A.Overlaps.Num(), B.Overlaps.Num());
+		}
+
+		auto HitsMatch = [](const FHitResult& HitA, const FHitResult& HitB)
+		{
+			return HitA.GetComponent() == HitB.GetComponent()
+				&& HitA.bBlockingHit == HitB.bBlockingHit
+				&& HitA.Location.Equals(HitB.Location)
+				&& HitA.ImpactNormal.Equals(HitB.ImpactNormal);
+		};
+
+		if (!HitsMatch(A.Hit, B.Hit))
+		{
+			return TEXT("hit differs");
+		}
+		for (int32 HitIdx = 0; HitIdx < A.Hits.Num(); ++HitIdx)
+		{
+			if (!HitsMatch(A.Hits[HitIdx], B.Hits[HitIdx]))
+			{
+				return FString::Printf(TEXT("hit %d differs"), HitIdx);
+			}
+		}
+		for (int32 OverlapIdx = 0; OverlapIdx < A.Overlaps.Num(); ++OverlapIdx)
+		{
+			if (A.Overlaps[OverlapIdx].GetComponent() != B.Overlaps[OverlapIdx].GetComponent())
+			{
+				return FString::Printf(TEXT("overlap %d differs"), OverlapIdx);
+			}
+		}
+
+		return FString();
+	}
+}
+
+void ACollisionQueryTestActor::TickCompare(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_Compare);
+
+	CompareVariants.Reset();
+	Desc.GetVariants(CompareVariants);
+
+	const int32 NumVariants = CompareVariants.Num();
+	CompareResults.SetNum(NumVariants);
+	CompareTimes.Reset();
+	CompareTimes.SetNumZeroed(NumVariants);
+
+	const uint32 DescHash = GetTypeHash(Desc);
+	const int32 BaselineIdx = FMath::Max(CompareVariants.IndexOfByPredicate([DescHash](const FCollisionQueryTestDesc& Variant) { return GetTypeHash(Variant) == DescHash; }), 0);
+
+	const UWorld* World = GetWorld();
+	const int32 NumRounds = FMath::Max(CompareRounds, 1);
+
+	// each round starts from a different variant, so no variant always runs straight after the same one
+	for (int32 Round = 0; Round < NumRounds; ++Round)
+	{
+		for (int32 Step = 0; Step < NumVariants; ++Step)
+		{
+			const int32 VariantIdx = (Round + Step) % NumVariants;
+			CompareVariants[VariantIdx].Execute(World, Start, End, Rot, CompareResults[VariantIdx]);
+			CompareTimes[VariantIdx] += CompareResults[VariantIdx].ExecutionTime;
+		}
+	}
+
+	for (double& Time : CompareTimes)
+	{
+		Time /= NumRounds;
+	}
+
+	LatencyHistory.AddSample(CompareResults[BaselineIdx].ExecutionTime);
+
+	DrawQueryResult(CompareVariants[BaselineIdx], Start, End, Rot, CompareResults[BaselineIdx]);
+	DrawCompareTable(BaselineIdx);
+}
+
+void ACollisionQueryTestActor::DrawCompareTable(int32 BaselineIdx) const
+{
+#if ENABLE_DRAW_DEBUG
+	using namespace CollisionQueryTestResults;
+
+	if (!GEngine)
+	{
+		return;
+	}
+
+	const double BaselineTime = CompareTimes[BaselineIdx];
+
+	TSet<FObjectKey> BaselineComponents;
+	const bool bBaselineHasHits = GetHitComponents(CompareVariants[BaselineIdx], CompareResults[BaselineIdx], BaselineComponents);
+
+	TSet<FObjectKey> VariantComponents;
+
+	// each actor's rows use their own range of message keys so that they are replaced every frame
+	const uint64 MessageKey = static_cast<uint64>(GetUniqueID()) << 8;
+	GEngine->AddOnScreenDebugMessage(MessageKey, 0.f, FColor::Cyan, FString::Printf(TEXT("%s: avg of %d interleaved rounds, relative to configured query"), *GetActorNameOrLabel(), FMath::Max(CompareRounds, 1)));
+
+	for (int32 VariantIdx = 0; VariantIdx < CompareVariants.Num(); ++VariantIdx)
+	{
+		const FCollisionQueryTestDesc& Variant = CompareVariants[VariantIdx];
+		const FCollisionQueryTestResult& Result = CompareResults[VariantIdx];
+
+		FString Diff;
+		if (VariantIdx == BaselineIdx)
+		{
+			Diff = TEXT("(configured)");
+		}
+		else if (Result.bResult != CompareResults[BaselineIdx].bResult)
+		{
+			Diff = Result.bResult ? TEXT("hit, configured did not") : TEXT("no hit, configured did");
+		}
+		else if (bBaselineHasHits && GetHitComponents(Variant, Result, VariantComponents))
+		{
+			const int32 NumExtra = VariantComponents.Difference(BaselineComponents).Num();
+			const int32 NumMissing = BaselineComponents.Difference(VariantComponents).Num();
+			if (NumExtra > 0 || NumMissing > 0)
+			{
+				Diff = FString::Printf(TEXT("+%d -%d components"), NumExtra, NumMissing);
+			}
+		}
+
+		const double Relative = BaselineTime > 0.0 ? CompareTimes[VariantIdx] / BaselineTime : 0.0;
+		const FString Row = FString::Printf(TEXT("%-45s %8.2fus %5.2fx  %-6s %s"), *Variant.ToString(), CompareTimes[VariantIdx] * 1e6, Relative, Result.bResult ? TEXT("hit") : TEXT("-"), *Diff);
+
+		const FColor Color = VariantIdx == BaselineIdx ? FColor::White : (Diff.IsEmpty() ? FColor::Silver : FColor::Yellow);
+		GEngine->AddOnScreenDebugMessage(MessageKey + VariantIdx + 1, 0.f, Color, Row);
+	}
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void FCollisionQueryPhaseBreakdown::Run(const UWorld* World, const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot)
+{
+	using namespace CollisionQueryTestResults;
+
+	FullDesc = Desc;
+	if (FullDesc.Query == ECollisionQueryTestType::Overlap)
+	{
+		FullDesc.BlockingAnyOrMulti = ECollisionQueryTestBlockingAnyOrMulti::Multi;
+	}
+	else
+	{
+		FullDesc.SingleMultiOrTest = ECollisionQueryTestSingleMultiOrTest::Multi;
+	}
+	FullDesc.QueryParams.bSkipNarrowPhase = false;
+	FullDesc.Prebuild();
+
+	FullDesc.Execute(World, Start, End, Rot, FullResult);
+	GetHitComponents(FullDesc, FullResult, Hits);
+
+	const FVector BroadphaseEnd = GetTraversalEnd(FullDesc, FullResult, Start, End);
+	const FCollisionQueryTraversalFilter Filter = FCollisionQueryTraversalFilter::Make(FullDesc);
+
+	Candidates.Reset();
+
+	if (FullDesc.By == ECollisionQueryTestBy::ObjectType)
+	{
+		Traversal.Record(World, Start, BroadphaseEnd, Rot, FullDesc.CollisionShape, FullDesc.Query == ECollisionQueryTestType::Overlap, Filter, false);
+		BroadphaseTime = Traversal.TraversalTime;
+
+		for (const FCollisionQueryTraversalLeaf& Leaf : Traversal.Leaves)
+		{
+			if (Leaf.NumShapes > 0 && Leaf.Component != FObjectKey())
+			{
+				Candidates.Add(Leaf.Component, Leaf.Bounds);
+			}
+		}
+		return;
+	}
+
+	// profiles are resolved to their channel and responses so that the responses can be changed
+	FCollisionQueryTestDesc BroadphaseDesc = FullDesc;
+	BroadphaseDesc.By = ECollisionQueryTestBy::Channel;
+	BroadphaseDesc.Channel = Filter.Channel;
+	BroadphaseDesc.ResponseParams.CollisionResponse = Filter.Responses;
+	BroadphaseDesc.ResponseParams.CollisionResponse.ReplaceChannels(ECR_Block, ECR_Overlap);
+	BroadphaseDesc.QueryParams.bSkipNarrowPhase = true;
+	BroadphaseDesc.Prebuild();
+
+	BroadphaseDesc.Execute(World, Start, BroadphaseEnd, Rot, BroadphaseResult);
+	BroadphaseTime = BroadphaseResult.ExecutionTime;
+
+	auto AddCandidate = [this](const UPrimitiveComponent* Component)
+	{
+		if (Component)
+		{
+			Candidates.Add(Component, Component->Bounds.GetBox());
+		}
+	};
+
+	for (const FHitResult& Hit : BroadphaseResult.Hits)
+	{
+		AddCandidate(Hit.GetComponent());
+	}
+	for (const FOverlapResult& Overlap : BroadphaseResult.Overlaps)
+	{
+		AddCandidate(Overlap.GetComponent());
+	}
+}
+
+int32 FCollisionQueryPhaseBreakdown::GetNumRejected() const
+{
+	int32 NumRejected = 0;
+	for (const TPair<FObjectKey, FBox>& Candidate : Candidates)
+	{
+		NumRejected += Hits.Contains(Candidate.Key) ? 0 : 1;
+	}
+	return NumRejected;
+}
+
+void ACollisionQueryTestActor::TickPhaseBreakdown(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_PhaseBreakdown);
+
+	PhaseBreakdown.Run(GetWorld(), Desc, Start, End, Rot);
+
+	LatencyHistory.AddSample(PhaseBreakdown.FullResult.ExecutionTime);
+
+	DrawQueryResult(PhaseBreakdown.FullDesc, Start, End, Rot, PhaseBreakdown.FullResult);
+	DrawPhaseBreakdown();
+}
+
+void ACollisionQueryTestActor::DrawPhaseBreakdown() const
+{
+#if ENABLE_DRAW_DEBUG
+	const float LineThickness = 0.f;
+	const FCollisionQueryDebugDrawView& DrawView = FCollisionQueryDebugDrawView::Get(GetWorld());
+
+	// highlight the bounds of candidates which passed the broadphase but were rejected by the narrowphase
+	for (const TPair<FObjectKey, FBox>& Candidate : PhaseBreakdown.Candidates)
+	{
+		if (!PhaseBreakdown.Hits.Contains(Candidate.Key))
+		{
+			const FBox& Bounds = Candidate.Value;
+			DrawDebugCollisionShape(DebugLines, DrawView, Bounds.GetCenter(), FQuat::Identity, FCollisionShape::MakeBox(Bounds.GetExtent()), FColor::Orange, 0, LineThickness);
+		}
+	}
+
+	const int32 NumCandidates = PhaseBreakdown.Candidates.Num();
+	const int32 NumRejected = PhaseBreakdown.GetNumRejected();
+	const double RejectionRatio = NumCandidates > 0 ? static_cast<double>(NumRejected) / NumCandidates : 0.0;
+
+	// the narrowphase time is estimated as the time the full query takes over the broadphase only query
+	const double BroadphaseTime = PhaseBreakdown.BroadphaseTime;
+	const double NarrowphaseTime = FMath::Max(PhaseBreakdown.FullResult.ExecutionTime - BroadphaseTime, 0.0);
+
+	const FString Text = FString::Printf(TEXT("Broadphase: %d candidates, %.2fus | Narrowphase: %d hits, %.2fus | %.0f%% rejected"),
+		NumCandidates, BroadphaseTime * 1e6, PhaseBreakdown.Hits.Num(), NarrowphaseTime * 1e6, RejectionRatio * 100.0);
+
+	DrawDebugString(GetWorld(), GetActorLocation() + FVector(0.f, 0.f, 40.f), Text, nullptr, FColor::Orange, 0.f, true);
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::TickTraversal(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_Traversal);
+
+	const UWorld* World = GetWorld();
+	Desc.Execute(World, Start, End, Rot, QueryResult);
+	LatencyHistory.AddSample(QueryResult.ExecutionTime);
+
+	// the scene query stops traversing at the blocking hit, so clip the traversal there too
+	const FVector TraversalEnd = CollisionQueryTestResults::GetTraversalEnd(Desc, QueryResult, Start, End);
+
+	Traversal.Record(World, Start, TraversalEnd, Rot, Desc.CollisionShape, Desc.Query == ECollisionQueryTestType::Overlap, FCollisionQueryTraversalFilter::Make(Desc), bTraversalDrawNodes);
+
+	DrawQueryResult(Desc, Start, End, Rot, QueryResult);
+	DrawTraversal();
+}
+
+void ACollisionQueryTestActor::DrawTraversal() const
+{
+#if ENABLE_DRAW_DEBUG
+	const float LineThickness = 0.f;
+	const FCollisionQueryDebugDrawView& DrawView = FCollisionQueryDebugDrawView::Get(GetWorld());
+
+	int32 MaxNodeLeaves = 1;
+	for (const FCollisionQueryTraversalNode& Node : Traversal.Nodes)
+	{
+		MaxNodeLeaves = FMath::Max(MaxNodeLeaves, Node.NumLeaves);
+	}
+
+	for (const FCollisionQueryTraversalNode& Node : Traversal.Nodes)
+	{
+		const float Heat = static_cast<float>(Node.NumLeaves) / MaxNodeLeaves;
+		const FColor Color = FLinearColor::LerpUsingHSV(FLinearColor::Green, FLinearColor::Yellow, Heat).ToFColor(true);
+		DrawDebugCollisionShape(DebugLines, DrawView, Node.Bounds.GetCenter(), FQuat::Identity, FCollisionShape::MakeBox(Node.Bounds.GetExtent()), Color, 0, LineThickness);
+	}
+
+	int32 MaxLeafTests = 1;
+	for (const FCollisionQueryTraversalLeaf& Leaf : Traversal.Leaves)
+	{
+		MaxLeafTests = FMath::Max(MaxLeafTests, Leaf.GetNumTests());
+	}
+
+	for (const FCollisionQueryTraversalLeaf& Leaf : Traversal.Leaves)
+	{
+		if (Leaf.Bounds.IsValid)
+		{
+			const float Heat = static_cast<float>(Leaf.GetNumTests()) / MaxLeafTests;
+			const FColor Color = FLinearColor::LerpUsingHSV(FLinearColor::Blue, FLinearColor::Red, Heat).ToFColor(true);
+			DrawDebugCollisionShape(DebugLines, DrawView, Leaf.Bounds.GetCenter(), FQuat::Identity, FCollisionShape::MakeBox(Leaf.Bounds.GetExtent()), Color, 0, LineThickness);
+		}
+	}
+
+	const FString Text = FString::Printf(TEXT("Traversal: %d nodes, %d leaves, %d visits, %d shapes tested, %.2fus"),
+		Traversal.Nodes.Num(), Traversal.Leaves.Num(), Traversal.NumVisits, Traversal.NumTests, Traversal.TraversalTime * 1e6);
+
+	DrawDebugString(GetWorld(), GetActorLocation() + FVector(0.f, 0.f, 40.f), Text, nullptr, FColor::Cyan, 0.f, true);
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::TickRawCompare(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_RawCompare);
+
+	const uint32 DescHash = GetTypeHash(Desc);
+	if (DescHash != RawDescHash)
+	{
+		RawDesc = FCollisionQueryTestRawDesc(Desc);
+		RawDescHash = DescHash;
+	}
+
+	const UWorld* World = GetWorld();
+	const int32 NumRounds = FMath::Max(RawRounds, 1);
+
+	double WorldTime = 0.0;
+	double RawTime = 0.0;
+
+	// alternate which path runs first, so that neither always runs with the caches warmed by the other
+	for (int32 Round = 0; Round < NumRounds; ++Round)
+	{
+		if (Round % 2 == 0)
+		{
+			Desc.Execute(World, Start, End, Rot, WorldPathResult);
+			RawDesc.Execute(World, Start, End, Rot, RawPathResult);
+		}
+		else
+		{
+			RawDesc.Execute(World, Start, End, Rot, RawPathResult);
+			Desc.Execute(World, Start, End, Rot, WorldPathResult);
+		}
+
+		WorldTime += WorldPathResult.ExecutionTime;
+		RawTime += RawPathResult.ExecutionTime;
+	}
+
+	LatencyHistory.AddSample(WorldPathResult.ExecutionTime);
+
+	DrawQueryResult(Desc, Start, End, Rot, WorldPathResult);
+	DrawRawCompare(WorldTime / NumRounds, RawTime / NumRounds);
+}
+
+void ACollisionQueryTestActor::DrawRawCompare(double WorldTime, double RawTime) const
+{
+#if ENABLE_DRAW_DEBUG
+	using namespace CollisionQueryTestResults;
+
+	const FString Diff = DescribeDifference(WorldPathResult, RawPathResult);
+	const double Overhead = WorldTime - RawTime;
+	const double OverheadRatio = WorldTime > 0.0 ? Overhead / WorldTime : 0.0;
+
+	const FString Status = Diff.IsEmpty() ? FString(TEXT("results match")) : TEXT("RESULTS DIFFER: ") + Diff;
+	const FString Text = FString::Printf(TEXT("UWorld: %.2fus | Raw: %.2fus | Wrapper: %.2fus (%.0f%%) | %s"),
+		WorldTime * 1e6, RawTime * 1e6, Overhead * 1e6, OverheadRatio * 100.0, *Status);
+
+	DrawDebugString(GetWorld(), GetActorLocation() + FVector(0.f, 0.f, 40.f), Text, nullptr, Diff.IsEmpty() ? FColor::Cyan : FColor::Yellow, 0.f, true);
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::TickStressTest(const FCollisionQueryTestDesc& Desc, const FVector& Start)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_StressTest);
+
+	const FBox Bounds(Start - StressExtent, Start + StressExtent);
+
+	uint32 SettingsHash = GetTypeHash(Desc);
+	SettingsHash = HashCombine(SettingsHash, GetTypeHash(Start));
+	SettingsHash = HashCombine(SettingsHash, GetTypeHash(StressExtent));
+	SettingsHash = HashCombine(SettingsHash, GetTypeHash(StressSeed));
+	SettingsHash = HashCombine(SettingsHash, GetTypeHash(StressQueries));
+	SettingsHash = HashCombine(SettingsHash, GetTypeHash(StressMaxThreads));
+
+	if (SettingsHash != StressSettingsHash || StressThreadCounts.Num() == 0)
+	{
+		StressTest.Generate(StressSeed, Bounds, StressQueries);
+		FCollisionQueryStressTest::GetThreadCounts(StressMaxThreads, StressThreadCounts);
+		StressResults.Reset();
+		StressResults.SetNum(StressThreadCounts.Num());
+		NextStressRun = 0;
+		StressSettingsHash = SettingsHash;
+	}
+
+	// one thread count is run per frame to keep the frame time down
+	const int32 RunIdx = NextStressRun;
+	NextStressRun = (NextStressRun + 1) % StressThreadCounts.Num();
+
+	StressResults[RunIdx] = StressTest.Run(GetWorld(), Desc, StressThreadCounts[RunIdx]);
+	LatencyHistory.AddSample(StressResults[RunIdx].Latency.Avg);
+
+	DrawStressTest(Bounds);
+}
+
+void ACollisionQueryTestActor::DrawStressTest(const FBox& Bounds) const
+{
+#if ENABLE_DRAW_DEBUG
+	const float LineThickness = 0.f;
+	const FCollisionQueryDebugDrawView& DrawView = FCollisionQueryDebugDrawView::Get(GetWorld());
+	DrawDebugCollisionShape(DebugLines, DrawView, Bounds.GetCenter(), FQuat::Identity, FCollisionShape::MakeBox(Bounds.GetExtent()), FColor::White, 0, LineThickness);
+
+	if (!GEngine)
+	{
+		return;
+	}
+
+	// each actor's rows use their own range of message keys so that they are replaced every frame
+	const uint64 MessageKey = static_cast<uint64>(GetUniqueID()) << 8;
+	GEngine->AddOnScreenDebugMessage(MessageKey, 0.f, FColor::Cyan, FString::Printf(TEXT("%s: %d queries from seed %d, speedup relative to 1 thread"), *GetActorNameOrLabel(), StressTest.Num(), StressSeed));
+
+	const double BaselineQueriesPerSecond = StressResults.Num() > 0 ? StressResults[0].QueriesPerSecond : 0.0;
+
+	for (int32 RunIdx = 0; RunIdx < StressResults.Num(); ++RunIdx)
+	{
+		const FCollisionQueryStressTestResult& Result = StressResults[RunIdx];
+		if (Result.NumThreads == 0)
+		{
+			continue; // not run yet
+		}
+
+		const double Speedup = BaselineQueriesPerSecond > 0.0 ? Result.QueriesPerSecond / BaselineQueriesPerSecond : 0.0;
+		FString Row = FString::Printf(TEXT("%3d threads %12.0f queries/s %5.2fx  %s  %d hits"), Result.NumThreads, Result.QueriesPerSecond, Speedup, *Result.Latency.ToString(), Result.NumHits);
+
+		// workers busy with other work leave their shares to fewer threads, so the row does not measure NumThreads
+		const bool bUnderThreaded = Result.NumThreadsRan < Result.NumThreads;
+		if (bUnderThreaded)
+		{
+			Row += FString::Printf(TEXT("  (only %d threads ran)"), Result.NumThreadsRan);
+		}
+		GEngine->AddOnScreenDebugMessage(MessageKey + RunIdx + 1, 0.f, bUnderThreaded ? FColor::Yellow : FColor::White, Row);
+	}
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::TickHeatmap(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FQuat& Rot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_Heatmap);
+
+	const int32 MaxCellsPerAxis = 64;
+
+	const FVector Extent = HeatmapExtent.ComponentMax(FVector(1.f));
+	const double CellSize = FMath::Max(HeatmapCellSize, 1.f);
+	const FIntVector Dims(
+		FMath::Clamp(static_cast<int32>(FMath::CeilToDouble(2.0 * Extent.X / CellSize)), 1, MaxCellsPerAxis),
+		FMath::Clamp(static_cast<int32>(FMath::CeilToDouble(2.0 * Extent.Y / CellSize)), 1, MaxCellsPerAxis),
+		FMath::Clamp(static_cast<int32>(FMath::CeilToDouble(2.0 * Extent.Z / CellSize)), 1, MaxCellsPerAxis));
+
+	// the cells exactly fill the volume
+	const FVector CellExtent = Extent / FVector(Dims);
+
+	FCollisionQueryTestDesc CellDesc = Desc;
+	CellDesc.BlockingAnyOrMulti = bHeatmapCountOverlaps ? ECollisionQueryTestBlockingAnyOrMulti::Multi : ECollisionQueryTestBlockingAnyOrMulti::AnyTest;
+	CellDesc.CollisionShape = FCollisionShape::MakeBox(CellExtent);
+	CellDesc.Prebuild();
+
+	uint32 SettingsHash = GetTypeHash(CellDesc);
+	SettingsHash = HashCombine(SettingsHash, GetTypeHash(Start));
+	SettingsHash = HashCombine(SettingsHash, GetTypeHash(Extent));
+	SettingsHash = HashCombine(SettingsHash, FCrc::MemCrc32(&Rot, sizeof(Rot)));
+
+	FCollisionQueryTestVoxelGrid& Grid = HeatmapGrid;
+	if (SettingsHash != Grid.SettingsHash || Grid.Num() == 0)
+	{
+		Grid.Init(Dims, 2.0 * CellExtent, FTransform(Rot, Start - Rot.RotateVector(Extent)), bHeatmapCountOverlaps);
+		Grid.SettingsHash = SettingsHash;
+	}
+
+	UpdateHeatmapDirtyCells(Start, Rot, Extent);
+
+	HeatmapDirtyCells.Reset();
+	for (TConstSetBitIterator<> It(Grid.Dirty); It; ++It)
+	{
+		HeatmapDirtyCells.Add(It.GetIndex());
+	}
+
+	const int32 NumDirtyCells = HeatmapDirtyCells.Num();
+	HeatmapSamples.SetNum(NumDirtyCells, false);
+	HeatmapExecutionTimes.SetNum(NumDirtyCells, false);
+
+	// results are gathered into byte arrays first as neighbouring bits of the grid cannot be written from different threads
+	const UWorld* World = GetWorld();
+	const TArray<int32>& DirtyCells = HeatmapDirtyCells;
+	TArray<uint8>& Samples = HeatmapSamples;
+	TArray<double>& ExecutionTimes = HeatmapExecutionTimes;
+
+	ParallelFor(NumDirtyCells, [&CellDesc, &Grid, &DirtyCells, &Samples, &ExecutionTimes, World, &Rot](int32 SampleIdx)
+	{
+		const FVector CellCenter = Grid.GetCellCenter(DirtyCells[SampleIdx]);
+
+		FCollisionQueryTestResult& Result = FCollisionQueryTestResult::GetThreadScratch();
+		CellDesc.Execute(World, CellCenter, CellCenter, Rot, Result);
+
+		const int32 NumOverlaps = CellDesc.BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::Multi ? Result.Overlaps.Num() : (Result.bResult ? 1 : 0);
+		Samples[SampleIdx] = static_cast<uint8>(FMath::Min(NumOverlaps, 255));
+		ExecutionTimes[SampleIdx] = Result.ExecutionTime;
+	});
+
+	for (int32 SampleIdx = 0; SampleIdx < NumDirtyCells; ++SampleIdx)
+	{
+		const int32 CellIdx = DirtyCells[SampleIdx];
+		Grid.Occupied[CellIdx] = Samples[SampleIdx] > 0;
+		Grid.Dirty[CellIdx] = false;
+		if (Grid.Counts.Num() > 0)
+		{
+			Grid.Counts[CellIdx] = Samples[SampleIdx];
+		}
+
+		LatencyHistory.AddSample(ExecutionTimes[SampleIdx]);
+	}
+
+	SET_DWORD_STAT(STAT_CollisionQueryTest_HeatmapCellsSampled, NumDirtyCells);
+
+	DrawHeatmap(Start, Rot, Extent);
+}
+
+void ACollisionQueryTestActor::UpdateHeatmapDirtyCells(const FVector& Center, const FQuat& Rot, const FVector& Extent)
+{
+	FCollisionQueryParams Params;
+	Params.MobilityType = EQueryMobilityType::Dynamic;
+
+	const FCollisionObjectQueryParams ObjectParams(FCollisionObjectQueryParams::InitType::AllObjects);
+
+	HeatmapOverlaps.Reset();
+	GetWorld()->OverlapMultiByObjectType(HeatmapOverlaps, Center, Rot, ObjectParams, FCollisionShape::MakeBox(Extent), Params);
+
+	FCollisionQueryTestVoxelGrid& Grid = HeatmapGrid;
+
+	// cells need sampling again where a movable primitive was and where it is now
+	TMap<FObjectKey, FBox> PrimitiveBounds;
+	PrimitiveBounds.Reserve(HeatmapOverlaps.Num());
+
+	for (const FOverlapResult& Overlap : HeatmapOverlaps)
+	{
+		const UPrimitiveComponent* Component = Overlap.GetComponent();
+		if (!Component || PrimitiveBounds.Contains(Component))
+		{
+			continue;
+		}
+
+		const FBox Bounds = Component->Bounds.GetBox();
+		PrimitiveBounds.Add(Component, Bounds);
+
+		const FBox* PrevBounds = Grid.PrimitiveBounds.Find(Component);
+		if (!PrevBounds || !(*PrevBounds == Bounds))
+		{
+			if (PrevBounds)
+			{
+				Grid.MarkDirty(*PrevBounds);
+			}
+			Grid.MarkDirty(Bounds);
+		}
+	}
+
+	for (const TPair<FObjectKey, FBox>& PrevPrimitive : Grid.PrimitiveBounds)
+	{
+		if (!PrimitiveBounds.Contains(PrevPrimitive.Key))
+		{
+			Grid.MarkDirty(PrevPrimitive.Value);
+		}
+	}
+
+	Grid.PrimitiveBounds = MoveTemp(PrimitiveBounds);
+}
+
+void ACollisionQueryTestActor::DrawHeatmap(const FVector& Center, const FQuat& Rot, const FVector& Extent) const
+{
+#if ENABLE_DRAW_DEBUG
+	const float LineThickness = 0.f;
+	const FCollisionQueryDebugDrawView& DrawView = FCollisionQueryDebugDrawView::Get(GetWorld());
+
+	const FCollisionQueryTestVoxelGrid& Grid = HeatmapGrid;
+
+	DrawDebugCollisionShape(DebugLines, DrawView, Center, Rot, FCollisionShape::MakeBox(Extent), FColor::White, 0, LineThickness);
+
+	int32 MaxCount = 1;
+	for (const uint8 Count : Grid.Counts)
+	{
+		MaxCount = FMath::Max<int32>(MaxCount, Count);
+	}
+
+	// shrink the drawn cells slightly so that neighbours can be told apart
+	const FCollisionShape CellShape = FCollisionShape::MakeBox(Grid.CellSize * 0.45);
+
+	for (TConstSetBitIterator<> It(Grid.Occupied); It; ++It)
+	{
+		const int32 CellIdx = It.GetIndex();
+
+		FColor Color = FColor::Blue;
+		if (Grid.Counts.Num() > 0)
+		{
+			const float Heat = static_cast<float>(Grid.Counts[CellIdx]) / MaxCount;
+			Color = FLinearColor::LerpUsingHSV(FLinearColor::Blue, FLinearColor::Red, Heat).ToFColor(true);
+		}
+
+		DrawDebugCollisionShape(DebugLines, DrawView, Grid.GetCellCenter(CellIdx), Rot, CellShape, Color, 0, LineThickness);
+	}
+#endif // ENABLE_DRAW_DEBUG
+}
+
+bool ACollisionQueryTestActor::CanReuseCachedResult(const FCollisionQueryTestDesc& Desc, uint32 QueryHash, const FVector& Start, const FVector& End)
+{
+	if (!bCacheResult || !bHasQueryResult || QueryHash != QueryResultHash)
+	{
+		return false;
+	}
+
+	if (CacheRevalidationInterval <= 0.f)
+	{
+		return true;
+	}
+
+	const double Time = GetWorld()->GetTimeSeconds();
+	if (Time - QueryResultTime < CacheRevalidationInterval)
+	{
+		return true;
+	}
+
+	// only objects which can move can have changed the result since it was cached
+	QueryResultTime = Time;
+	return !AreMovableObjectsNearby(Desc, Start, End);
+}
+
+bool ACollisionQueryTestActor::AreMovableObjectsNearby(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_CacheRevalidation);
+
+	FBox Bounds(ForceInit);
+	Bounds += Start;
+	Bounds += End;
+	Bounds = Bounds.ExpandBy(Desc.CollisionShape.GetExtent().GetMax());
+
+	FCollisionQueryParams Params;
+	Params.MobilityType = EQueryMobilityType::Dynamic;
+
+	const FCollisionObjectQueryParams ObjectParams(FCollisionObjectQueryParams::InitType::AllObjects);
+
+	return GetWorld()->OverlapAnyTestByObjectType(Bounds.GetCenter(), FQuat::Identity, ObjectParams, FCollisionShape::MakeBox(Bounds.GetExtent()), Params);
+}
+
+void ACollisionQueryTestActor::FlushDebugLines() const
+{
+#if ENABLE_DRAW_DEBUG
+	if (bDrawWithResultComponent)
+	{
+		for (const FBatchedLine& Line : DebugLines)
+		{
+			ResultComponent->AddLine(Line.Start, Line.End, Line.Color.ToFColor(true));
+		}
+		DebugLines.Reset();
+	}
+	else
+	{
+		DrawDebugBatchedLines(GetWorld(), DebugLines, false, 0.f, 0);
+	}
+
+	// commit even when empty, so that the component stops drawing once it is switched off
+	ResultComponent->Commit();
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::DrawHitPoint(const FVector& Position, float Size, const FColor& Color) const
+{
+#if ENABLE_DRAW_DEBUG
+	if (bDrawWithResultComponent)
+	{
+		// the component only draws lines, so the point is drawn as a world space cross
+		const float HalfSize = Size * 0.5f;
+		DrawDebugLine(DebugLines, Position - FVector(HalfSize, 0.f, 0.f), Position + FVector(HalfSize, 0.f, 0.f), Color);
+		DrawDebugLine(DebugLines, Position - FVector(0.f, HalfSize, 0.f), Position + FVector(0.f, HalfSize, 0.f), Color);
+		DrawDebugLine(DebugLines, Position - FVector(0.f, 0.f, HalfSize), Position + FVector(0.f, 0.f, HalfSize), Color);
+	}
+	else
+	{
+		DrawDebugPoint(GetWorld(), Position, Size, Color, false, 0.f, 0);
+	}
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void ACollisionQueryTestActor::FadeDebugLines(int32 FirstLine, float ResultAge) const
+{
+	const float FadeTime = CVarCollisionQueryTestResultFadeTime.GetValueOnGameThread();
+	if (FadeTime <= 0.f)
+	{
+		return;
+	}
+
+	// stale results fade to a quarter of their brightness, so they can still be seen
+	const float Brightness = 1.f - 0.75f * FMath::Clamp(ResultAge / FadeTime, 0.f, 1.f);
+
+	for (int32 LineIdx = FirstLine; LineIdx < DebugLines.Num(); ++LineIdx)
+	{
+		FLinearColor& Color = DebugLines[LineIdx].Color;
+		Color = FLinearColor(Color.R * Brightness, Color.G * Brightness, Color.B * Brightness, Color.A);
+	}
+}
+
+void ACollisionQueryTestActor::DrawLatencyStats(const FCollisionQueryTestDesc& Desc) const
+{
+#if ENABLE_DRAW_DEBUG
+	if (!bShowLatencyStats || LatencyHistory.Num() == 0)
+	{
+		return;
+	}
+
+	const FCollisionQueryLatencySummary Summary = LatencyHistory.Summarize();
+	const FString Text = FString::Printf(TEXT("%s%s: %s"), bAsync ? TEXT("Async ") : TEXT(""), *Desc.ToString(), *Summary.ToString());
+
+	DrawDebugString(GetWorld(), GetActorLocation() + FVector(0.f, 0.f, 20.f), Text, nullptr, FColor::White, 0.f, true);
+#endif // ENABLE_DRAW_DEBUG
+}
+
+#if WITH_EDITOR
+void ACollisionQueryTestActor::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	UpdateQueryDesc();
+
+	// the retained lines were drawn for the old settings
+	ResetHitSet();
+
+	// samples taken with different settings are not comparable
+	LatencyHistory.Reset();
+	bHasQueryResult = false;
+}
+#endif
+
+void ACollisionQueryTestActor::OnAsyncTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	const FCollisionQueryTestDesc& Desc = QueryDesc;
+	if (Desc.Query == ECollisionQueryTestType::Overlap)
+	{
+		return; // settings changed while the query was in flight
+	}
+
+	FCollisionQueryTestResult& Result = AsyncResult;
+	Result.Reset();
+	Result.Hits.Append(Datum.OutHits);
+
+	if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Single)
+	{
+		if (Result.Hits.Num() > 0)
+		{
+			Result.Hit = Result.Hits[0];
+			Result.bResult = Result.Hit.bBlockingHit;
+		}
+		Result.Hits.Reset();
+	}
+	else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Multi)
+	{
+		// object type queries only report touches, and like the sync query succeed on any of them
+		Result.bResult = Desc.By == ECollisionQueryTestBy::ObjectType
+			? Result.Hits.Num() > 0
+			: Result.Hits.Num() > 0 && Result.Hits.Last().bBlockingHit;
+	}
+	else if (Desc.SingleMultiOrTest == ECollisionQueryTestSingleMultiOrTest::Test)
+	{
+		Result.bResult = Result.Hits.Num() > 0;
+		Result.Hits.Reset();
+	}
+
+	if (ShouldDiffHits(Desc))
+	{
+		UpdateHitSet(Desc, Result);
+	}
+
+	DrawQueryResult(Desc, Datum.Start, Datum.End, Datum.Rot, Result, !ShouldDiffHits(Desc));
+	FlushDebugLines();
+}
+
+void ACollisionQueryTestActor::OnAsyncOverlapCompleted(const FTraceHandle& Handle, FOverlapDatum& Datum)
+{
+	const FCollisionQueryTestDesc& Desc = QueryDesc;
+	if (Desc.Query != ECollisionQueryTestType::Overlap)
+	{
+		return; // settings changed while the query was in flight
+	}
+
+	FCollisionQueryTestResult& Result = AsyncResult;
+	Result.Reset();
+	Result.Overlaps.Append(Datum.OutOverlaps);
+
+	if (Desc.BlockingAnyOrMulti == ECollisionQueryTestBlockingAnyOrMulti::AnyTest || Desc.By == ECollisionQueryTestBy::ObjectType)
+	{
+		// object type overlaps only report touches, and like the sync query succeed on any of them
+		Result.bResult = Result.Overlaps.Num() > 0;
+	}
+	else
+	{
+		Result.bResult = Result.Overlaps.ContainsByPredicate([](const FOverlapResult& Overlap) { return Overlap.bBlockingHit; });
+	}
+
+	if (ShouldDiffHits(Desc))
+	{
+		UpdateHitSet(Desc, Result);
+	}
+
+	DrawQueryResult(Desc, Datum.Pos, Datum.Pos, Datum.Rot, Result, !ShouldDiffHits(Desc));
+	FlushDebugLines();
 }
 
 TArray<FName> ACollisionQueryTestActor::GetCollisionProfileOptions() const
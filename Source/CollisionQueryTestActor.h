@@ -12,9 +12,18 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "CollisionQueryParams.h"
+#include "WorldCollision.h"
+#include "Components/LineBatchComponent.h"
+#include "UObject/ObjectKey.h"
+#include "CollisionQueryHitSet.h"
+#include "CollisionQueryTestStats.h"
+#include "CollisionQueryTraversal.h"
 
 #include "CollisionQueryTestActor.generated.h"
 
+class UCollisionQueryResultComponent;
+class USplineComponent;
+
 UENUM()
 enum class ECollisionQueryTestType : uint8
 {
@@ -63,6 +72,257 @@ enum class ECollisionQueryTestMobilityType : uint8
 	Dynamic
 };
 
+UENUM()
+enum class ECollisionQueryTestPattern : uint8
+{
+	None,
+	Grid,		// parallel queries from a grid of points on the plane perpendicular to the query
+	Cone,		// queries fanning out from the start within PatternConeAngle of the query direction
+	Hemisphere,	// queries fanning out from the start over the hemisphere around the query direction
+	Ring		// parallel queries from concentric rings of points around the query
+};
+
+/** What an actor does each tick, resolved from its settings in order of precedence. */
+enum class ECollisionQueryTestTickMode : uint8
+{
+	Async,
+	Path,
+	Compare,
+	PhaseBreakdown,
+	Traversal,
+	RawCompare,
+	StressTest,
+	Heatmap,
+	Pattern,
+	Single		// a single synchronous query, which the subsystem can batch unless its result is cached
+};
+
+/**
+ * The result of a single collision query. Which members are filled in depends on the type of query.
+ */
+struct FCollisionQueryTestResult
+{
+	bool bResult = false;
+	double ExecutionTime = 0.0; // seconds
+	FHitResult Hit;
+	TArray<FHitResult> Hits;
+	TArray<FOverlapResult> Overlaps;
+
+	/** Resets the result, keeping the capacity of its arrays so that later queries with as many hits do not allocate. */
+	void Reset();
+
+	/** Bytes allocated by the hit and overlap arrays. */
+	SIZE_T GetAllocatedSize() const { return Hits.GetAllocatedSize() + Overlaps.GetAllocatedSize(); }
+
+	/**
+	 * Result for queries run on the calling thread whose result is only needed briefly, eg. each query of a parallel pattern.
+	 * Shared by every test actor, so its arrays grow to the largest result any of them have seen and then stop allocating.
+	 */
+	static FCollisionQueryTestResult& GetThreadScratch();
+};
+
+/**
+ * A fully resolved description of a collision query, built from the settings of a test actor.
+ */
+struct FCollisionQueryTestDesc
+{
+	ECollisionQueryTestType Query = ECollisionQueryTestType::LineTrace;
+	ECollisionQueryTestSingleMultiOrTest SingleMultiOrTest = ECollisionQueryTestSingleMultiOrTest::Single;
+	ECollisionQueryTestBlockingAnyOrMulti BlockingAnyOrMulti = ECollisionQueryTestBlockingAnyOrMulti::Multi;
+	ECollisionQueryTestBy By = ECollisionQueryTestBy::Channel;
+
+	ECollisionChannel Channel = ECollisionChannel::ECC_Pawn;
+	FName CollisionProfileName;
+
+	FCollisionShape CollisionShape;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+	FCollisionObjectQueryParams ObjectQueryParams;
+
+	using FExecuteFunction = bool (*)(const FCollisionQueryTestDesc& Desc, const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FCollisionQueryTestResult& OutResult);
+
+	/** Set by Prebuild. When null, Execute looks the function up on every call. */
+	FExecuteFunction Executor = nullptr;
+
+	/**
+	 * Picks the function which makes this query from a compile time table of every type, mode and by combination, so that
+	 * Execute makes a single indirect call rather than branching on them. Must be called again after changing any of them.
+	 */
+	void Prebuild();
+
+	/** Looks up the function which makes this query in the table used by Prebuild. */
+	FExecuteFunction GetExecuteFunction() const;
+
+	/** Performs the query and blocks until it is complete. Overlaps are performed at Start. */
+	bool Execute(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FCollisionQueryTestResult& OutResult) const;
+
+	/** Issues the query via the world's async trace API. The relevant delegate will be called on the next frame. */
+	FTraceHandle ExecuteAsync(UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FTraceDelegate* TraceDelegate, FOverlapDelegate* OverlapDelegate) const;
+
+	/** Short readable description of the query, eg. "Sweep Multi ByChannel Capsule Complex" */
+	FString ToString() const;
+
+	/** Adds a copy of this query for every single/multi/test, by and simple/complex combination its type supports. */
+	void GetVariants(TArray<FCollisionQueryTestDesc>& OutVariants) const;
+
+	/** Hashes every setting which can affect the result of the query. */
+	friend uint32 GetTypeHash(const FCollisionQueryTestDesc& Desc);
+};
+
+/**
+ * A query description resolved down to the arguments of the physics interface, so that it can be executed without going
+ * through the UWorld query functions. The conversions those functions make on every call (looking up profiles, defaulting
+ * the channel and responses of object type queries, turning zero size sweeps into line traces) are made once on creation.
+ */
+struct FCollisionQueryTestRawDesc
+{
+	ECollisionQueryTestType Query = ECollisionQueryTestType::LineTrace;
+	ECollisionQueryTestSingleMultiOrTest SingleMultiOrTest = ECollisionQueryTestSingleMultiOrTest::Single;
+	ECollisionQueryTestBlockingAnyOrMulti BlockingAnyOrMulti = ECollisionQueryTestBlockingAnyOrMulti::Multi;
+
+	ECollisionChannel Channel = ECollisionChannel::ECC_Pawn;
+	FCollisionShape CollisionShape;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+	FCollisionObjectQueryParams ObjectQueryParams;
+
+	FCollisionQueryTestRawDesc() = default;
+	explicit FCollisionQueryTestRawDesc(const FCollisionQueryTestDesc& Desc);
+
+	/** Performs the query through FPhysicsInterface and blocks until it is complete. Overlaps are performed at Start. */
+	bool Execute(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, FCollisionQueryTestResult& OutResult) const;
+};
+
+/**
+ * Structure-of-arrays buffer holding the inputs and results of a pattern of queries.
+ * Kept between frames so that its allocations are reused.
+ */
+struct FCollisionQueryTestPatternBuffer
+{
+	TArray<FVector> Starts;
+	TArray<FVector> Ends;
+	TArray<FVector> StopLocations;
+	TArray<FVector> ImpactPoints;
+	TArray<int32> NumHits;
+	TArray<bool> Results;
+	TArray<double> ExecutionTimes;
+
+	int32 Num() const { return Starts.Num(); }
+	void SetNum(int32 NewNum);
+};
+
+/**
+ * Bit-packed grid of overlap results sampled over a box volume, for the heatmap mode.
+ * Kept between frames so that only cells touched by moving primitives need to be sampled again.
+ */
+struct FCollisionQueryTestVoxelGrid
+{
+	FIntVector Dims = FIntVector::ZeroValue;
+	FVector CellSize = FVector::ZeroVector;
+	FTransform Transform; // grid space to world space, with the origin at the min corner of the grid
+
+	TBitArray<> Occupied;	// whether any overlap was found in the cell
+	TBitArray<> Dirty;		// whether the cell needs to be sampled again
+	TArray<uint8> Counts;	// number of overlaps found in the cell, saturating at 255. Empty unless counting overlaps
+
+	/** Bounds of the movable primitives in the volume when it was last checked, to find those which have moved. */
+	TMap<FObjectKey, FBox> PrimitiveBounds;
+
+	uint32 SettingsHash = 0;
+
+	int32 Num() const { return Dims.X * Dims.Y * Dims.Z; }
+	void Init(const FIntVector& NewDims, const FVector& NewCellSize, const FTransform& NewTransform, bool bCountOverlaps);
+	FVector GetCellCenter(int32 CellIdx) const;
+
+	/** Marks every cell which intersects the world space bounds as needing to be sampled again. */
+	void MarkDirty(const FBox& WorldBounds);
+};
+
+/**
+ * Result of running a stress test's queries from a number of threads at once.
+ */
+struct FCollisionQueryStressTestResult
+{
+	int32 NumThreads = 0;
+	int32 NumThreadsRan = 0; // distinct threads which ran a share, fewer than NumThreads when workers were busy
+	int32 NumQueries = 0;
+	int32 NumHits = 0;
+	double WallTime = 0.0; // seconds from the first thread starting to the last finishing
+	double QueriesPerSecond = 0.0;
+	FCollisionQueryLatencySummary Latency;
+};
+
+/**
+ * A set of random queries inside a box, run from increasing numbers of threads at once to measure how query throughput
+ * scales with cores while the threads contend for the physics scene. The queries are generated from a seed, so a run can
+ * be reproduced exactly.
+ */
+class FCollisionQueryStressTest
+{
+public:
+	/** Generates the starts, ends and rotations of the queries. Starts and ends are both inside Bounds. */
+	void Generate(int32 Seed, const FBox& Bounds, int32 NumQueries);
+
+	/**
+	 * Runs every query once, split evenly into NumThreads shares run in parallel. The calling thread helps run them, so
+	 * the run always completes, but the shares only all run at once if there are at least NumThreads - 1 idle workers. The
+	 * number of threads which actually ran shares is reported in the result.
+	 */
+	FCollisionQueryStressTestResult Run(const UWorld* World, const FCollisionQueryTestDesc& Desc, int32 NumThreads);
+
+	/** Gets the thread counts to run at: 1, 2, 4 ... and MaxThreads, which is clamped to the number of worker threads plus one. Zero for the maximum. */
+	static void GetThreadCounts(int32 MaxThreads, TArray<int32>& OutThreadCounts);
+
+	int32 Num() const { return Starts.Num(); }
+
+private:
+	TArray<FVector> Starts;
+	TArray<FVector> Ends;
+	TArray<FQuat> Rots;
+
+	// per query results of the last run
+	TArray<double> ExecutionTimes;
+	TArray<bool> Results;
+};
+
+/**
+ * A query run in full and broadphase only, to tell how many candidates the broadphase passes to the narrowphase and how
+ * many of those the narrowphase rejects. Both runs are multi queries so that every candidate is reported, and the
+ * broadphase run is clipped to the full query's blocking hit, where the scene query stops traversing.
+ */
+struct FCollisionQueryPhaseBreakdown
+{
+	/** The query as run in full, and its result. */
+	FCollisionQueryTestDesc FullDesc;
+	FCollisionQueryTestResult FullResult;
+
+	/** Bounds of each component with a shape which passed the broadphase and the query's filter. */
+	TMap<FObjectKey, FBox> Candidates;
+
+	/** Components the full query hit or overlapped. */
+	TSet<FObjectKey> Hits;
+
+	double BroadphaseTime = 0.0;
+
+	/**
+	 * Runs Desc as a multi query in full, then broadphase only. Without the narrowphase every candidate is reported at
+	 * a distance of zero, so the broadphase run makes every blocking response a touch to keep a blocking candidate from
+	 * clipping the query to nothing. Queries by object type cannot change their responses, so their candidates are
+	 * counted by repeating the broadphase against the acceleration structure instead.
+	 */
+	void Run(const UWorld* World, const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot);
+
+	int32 GetNumRejected() const;
+
+private:
+	FCollisionQueryTestResult BroadphaseResult;
+	FCollisionQueryTraversal Traversal;
+};
+
+class ACollisionQueryTestActor;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnCollisionQueryHitSetChanged, ACollisionQueryTestActor* /*Actor*/, TConstArrayView<FCollisionQueryHitChange> /*Changes*/);
+
 /**
  * Test actor that performs a custom line trace/sweep/overlap test on tick and draws the result.
  */
@@ -74,6 +334,8 @@ class ACollisionQueryTestActor : public AActor
 public:
 	ACollisionQueryTestActor(const FObjectInitializer& ObjectInitializer);
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaSeconds) override;
 
 
@@ -88,6 +350,172 @@ public:
 
 	UPROPERTY(EditAnywhere)
 	ECollisionQueryTestBy By = ECollisionQueryTestBy::Channel;
+
+	/** Issue the query through the world's async trace API and draw the result when it completes on the next frame. */
+	UPROPERTY(EditAnywhere)
+	bool bAsync = false;
+
+	/** Expand the query into a pattern of PatternCountX * PatternCountY queries around the start transform. */
+	UPROPERTY(EditAnywhere, Category="Pattern", meta=(EditCondition="!bAsync"))
+	ECollisionQueryTestPattern Pattern = ECollisionQueryTestPattern::None;
+
+	UPROPERTY(EditAnywhere, Category="Pattern", meta=(EditCondition="!bAsync&&Pattern!=ECollisionQueryTestPattern::None", EditConditionHides, ClampMin=1, UIMax=64))
+	int32 PatternCountX = 8;
+
+	UPROPERTY(EditAnywhere, Category="Pattern", meta=(EditCondition="!bAsync&&Pattern!=ECollisionQueryTestPattern::None", EditConditionHides, ClampMin=1, UIMax=64))
+	int32 PatternCountY = 8;
+
+	/** Distance between neighbouring queries for the Grid and Ring patterns. */
+	UPROPERTY(EditAnywhere, Category="Pattern", meta=(EditCondition="!bAsync&&(Pattern==ECollisionQueryTestPattern::Grid||Pattern==ECollisionQueryTestPattern::Ring)", EditConditionHides))
+	float PatternSpacing = 20.f;
+
+	/** Half angle of the Cone pattern, in degrees. */
+	UPROPERTY(EditAnywhere, Category="Pattern", meta=(EditCondition="!bAsync&&Pattern==ECollisionQueryTestPattern::Cone", EditConditionHides, ClampMin=0, ClampMax=180))
+	float PatternConeAngle = 30.f;
+
+	/** Execute the pattern's queries across worker threads with ParallelFor. */
+	UPROPERTY(EditAnywhere, Category="Pattern", meta=(EditCondition="!bAsync&&Pattern!=ECollisionQueryTestPattern::None", EditConditionHides))
+	bool bPatternParallel = true;
+
+	/**
+	 * Trace or sweep along the Path spline instead of straight from Start to End. The path is split into PathSegments
+	 * straight segments which are queried in order, stopping at the first hit.
+	 */
+	UPROPERTY(EditAnywhere, Category="Path", meta=(EditCondition="!bAsync&&Query!=ECollisionQueryTestType::Overlap"))
+	bool bSweepAlongPath = false;
+
+	UPROPERTY(EditAnywhere, Category="Path", meta=(EditCondition="!bAsync&&Query!=ECollisionQueryTestType::Overlap&&bSweepAlongPath", EditConditionHides, ClampMin=1, UIMax=128))
+	int32 PathSegments = 8;
+
+	/**
+	 * Query all segments at once across worker threads, then take the first hit along the path. Segments after the first
+	 * hit are queried needlessly, but the path finishes sooner when hits are rare.
+	 */
+	UPROPERTY(EditAnywhere, Category="Path", meta=(EditCondition="!bAsync&&Query!=ECollisionQueryTestType::Overlap&&bSweepAlongPath", EditConditionHides))
+	bool bPathBatched = false;
+
+	/**
+	 * Run the query in every single/multi/test, by and simple/complex combination each tick, and show their relative cost
+	 * and how their results differ from the configured query in an on-screen table.
+	 */
+	UPROPERTY(EditAnywhere, Category="Compare", meta=(EditCondition="!bAsync"))
+	bool bCompare = false;
+
+	/** Number of times each combination is run per tick. The combinations are interleaved in a different order each round, to even out cache effects. */
+	UPROPERTY(EditAnywhere, Category="Compare", meta=(EditCondition="!bAsync&&bCompare", EditConditionHides, ClampMin=1, UIMax=32))
+	int32 CompareRounds = 4;
+
+	/**
+	 * Run the query twice each tick, once in full and once broadphase only (with bSkipNarrowPhase, or for queries by
+	 * object type against the acceleration structure directly), and show the number of broadphase candidates, how many
+	 * the narrowphase rejected and the time spent in each phase. Rejected candidates are highlighted in orange. Both runs
+	 * are multi queries so that every candidate is reported.
+	 */
+	UPROPERTY(EditAnywhere, Category="Phases", meta=(EditCondition="!bAsync"))
+	bool bPhaseBreakdown = false;
+
+	/**
+	 * Repeat the broadphase of the query directly against the physics scene's acceleration structure and draw the leaf
+	 * bounds it reached, coloured by the number of shapes each had tested, with totals next to the actor. Shows whether
+	 * a query is slow because of what it covers or because the structure is poorly balanced around it.
+	 */
+	UPROPERTY(EditAnywhere, Category="Traversal", meta=(EditCondition="!bAsync"))
+	bool bTraversal = false;
+
+	/** Also draw the nodes of the structure the query passes through, coloured by the number of reached leaves inside each. Not available in shipping builds. */
+	UPROPERTY(EditAnywhere, Category="Traversal", meta=(EditCondition="!bAsync&&bTraversal", EditConditionHides))
+	bool bTraversalDrawNodes = true;
+
+	/**
+	 * Sample overlaps on a 3D grid of cells over a box volume around the actor and draw the occupied cells as a heatmap.
+	 * Cells are only sampled again when a movable primitive moves through them.
+	 */
+	UPROPERTY(EditAnywhere, Category="Heatmap", meta=(EditCondition="!bAsync&&Query==ECollisionQueryTestType::Overlap"))
+	bool bHeatmap = false;
+
+	/** Half size of the sampled volume. */
+	UPROPERTY(EditAnywhere, Category="Heatmap", meta=(EditCondition="!bAsync&&Query==ECollisionQueryTestType::Overlap&&bHeatmap", EditConditionHides))
+	FVector HeatmapExtent = { 500.f, 500.f, 200.f };
+
+	/** Size of each cell. At most 64 cells are sampled along each axis. */
+	UPROPERTY(EditAnywhere, Category="Heatmap", meta=(EditCondition="!bAsync&&Query==ECollisionQueryTestType::Overlap&&bHeatmap", EditConditionHides, ClampMin=1))
+	float HeatmapCellSize = 50.f;
+
+	/** Count the overlaps in each cell with an overlap multi instead of an overlap any test, to show where candidate counts explode. */
+	UPROPERTY(EditAnywhere, Category="Heatmap", meta=(EditCondition="!bAsync&&Query==ECollisionQueryTestType::Overlap&&bHeatmap", EditConditionHides))
+	bool bHeatmapCountOverlaps = false;
+
+	/**
+	 * Also run the query through the physics interface directly, bypassing the UWorld query functions, and show the time
+	 * taken by each and whether their results match. Shows how much the UWorld layer costs on top of the scene query.
+	 */
+	UPROPERTY(EditAnywhere, Category="Raw", meta=(EditCondition="!bAsync"))
+	bool bRawCompare = false;
+
+	/** Number of times each path is run per frame, alternating which goes first. Their times are averaged over the rounds. */
+	UPROPERTY(EditAnywhere, Category="Raw", meta=(EditCondition="!bAsync&&bRawCompare", EditConditionHides, ClampMin=1, UIMax=64))
+	int32 RawRounds = 8;
+
+	/**
+	 * Run StressQueries random queries inside StressExtent of the actor, with its shape and settings, from 1, 2, 4 ... worker
+	 * threads at once, and show the throughput and latency at each thread count. One thread count is run per frame.
+	 */
+	UPROPERTY(EditAnywhere, Category="Stress", meta=(EditCondition="!bAsync"))
+	bool bStressTest = false;
+
+	/** Half size of the box around the actor which the random queries start and end in. */
+	UPROPERTY(EditAnywhere, Category="Stress", meta=(EditCondition="!bAsync&&bStressTest", EditConditionHides))
+	FVector StressExtent = FVector(1000.f, 1000.f, 1000.f);
+
+	/** Seed the random queries are generated from. The same seed always generates the same queries. */
+	UPROPERTY(EditAnywhere, Category="Stress", meta=(EditCondition="!bAsync&&bStressTest", EditConditionHides))
+	int32 StressSeed = 0;
+
+	/** Number of queries split between the threads at each thread count. */
+	UPROPERTY(EditAnywhere, Category="Stress", meta=(EditCondition="!bAsync&&bStressTest", EditConditionHides, ClampMin=1, UIMax=100000))
+	int32 StressQueries = 2000;
+
+	/** Largest number of threads to run from, clamped to the number of worker threads plus the game thread. Zero for all of them. */
+	UPROPERTY(EditAnywhere, Category="Stress", meta=(EditCondition="!bAsync&&bStressTest", EditConditionHides, ClampMin=0))
+	int32 StressMaxThreads = 0;
+
+	/** Show the min/avg/p95/p99/max time of recent queries next to the debug draw. In async mode this is the time taken to issue the query. */
+	UPROPERTY(EditAnywhere, Category="Stats")
+	bool bShowLatencyStats = true;
+
+	/**
+	 * Draw results with ResultComponent instead of the world's line batcher. It keeps the lines in persistent vertex buffers
+	 * and only uploads those which changed, so scales better to large numbers of hits. Lines are always one pixel thick.
+	 */
+	UPROPERTY(EditAnywhere, Category="Draw")
+	bool bDrawWithResultComponent = false;
+
+	/**
+	 * For multi queries, keep the hits or overlaps of the last result and only redraw those which were added, removed or
+	 * changed since, as retained lines of ResultComponent which stay drawn until they change. The changes are broadcast
+	 * by OnHitSetChanged. A result which is the same as the last costs almost nothing to draw.
+	 */
+	UPROPERTY(EditAnywhere, Category="Diff")
+	bool bDiffHits = false;
+
+	/** Distance a hit, or the bounds of an overlapped component, must move by to count as changed. */
+	UPROPERTY(EditAnywhere, Category="Diff", meta=(EditCondition="bDiffHits", EditConditionHides, ClampMin=0))
+	float DiffTolerance = 0.1f;
+
+	/** Reuse the last result until the query transforms or settings change, instead of re-running the query every tick. */
+	UPROPERTY(EditAnywhere, Category="Cache", meta=(EditCondition="!bAsync&&Pattern==ECollisionQueryTestPattern::None"))
+	bool bCacheResult = false;
+
+	/**
+	 * How often a cached result is revalidated, in seconds. When the interval expires the query is only re-run if there are
+	 * movable objects within its bounds. Zero to never revalidate.
+	 */
+	UPROPERTY(EditAnywhere, Category="Cache", meta=(EditCondition="!bAsync&&Pattern==ECollisionQueryTestPattern::None&&bCacheResult", EditConditionHides, ClampMin=0))
+	float CacheRevalidationInterval = 0.5f;
+
+	/** Number of recent query times the latency stats are computed from. */
+	UPROPERTY(EditAnywhere, Category="Stats", meta=(ClampMin=1, UIMax=1024))
+	int32 LatencySampleCount = 128;
 	
 
 	UPROPERTY(EditAnywhere, meta=(EditCondition="Query!=ECollisionQueryTestType::LineTrace", EditConditionHides))
@@ -136,6 +564,10 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay)
 	ECollisionQueryTestMobilityType MobilityType = ECollisionQueryTestMobilityType::Any;
 
+	/** Tag the query is totalled under by CollisionQueryTest.Capture, which can also be drawn with the TraceTag console command. The owner tag is the actor's name. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay)
+	FName TraceTag = TEXT("CollisionQueryTest");
+
 	
 	UPROPERTY(VisibleDefaultsOnly)
 	TObjectPtr<USceneComponent> StartComponent = nullptr;
@@ -143,10 +575,156 @@ public:
 	UPROPERTY(VisibleDefaultsOnly)
 	TObjectPtr<USceneComponent> EndComponent = nullptr;
 
+	/** Path followed when bSweepAlongPath is set. */
+	UPROPERTY(VisibleDefaultsOnly)
+	TObjectPtr<USplineComponent> PathComponent = nullptr;
+
+	/** Draws the results when bDrawWithResultComponent is set. */
+	UPROPERTY(VisibleDefaultsOnly)
+	TObjectPtr<UCollisionQueryResultComponent> ResultComponent = nullptr;
+
 	
 	UFUNCTION()
 	TArray<FName> GetCollisionProfileOptions() const;
 
 	static EQueryMobilityType ConvertToQueryMobilityType(ECollisionQueryTestMobilityType TestType);
 
+	/** Builds a query description from the current settings of the actor. */
+	FCollisionQueryTestDesc MakeQueryDesc() const;
+
+	/** The query description built from the settings of the actor on BeginPlay, and rebuilt whenever they are edited. */
+	const FCollisionQueryTestDesc& GetQueryDesc() const { return QueryDesc; }
+
+	/** Draws the result of a query built from MakeQueryDesc. Without bDrawHits the hit points of multi queries are left out. */
+	void DrawQueryResult(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result, bool bDrawHits = true) const;
+
+	/** Which of its modes the actor runs each tick. Only one runs, even if the settings of several are enabled. */
+	ECollisionQueryTestTickMode GetTickMode() const;
+
+	/** Whether the actor's query can be run by UCollisionQueryTestSubsystem as part of its batch, ie. it is a single synchronous query. */
+	bool CanTickInSubsystem() const;
+
+	/**
+	 * Called every frame by UCollisionQueryTestSubsystem with the result of this actor's batched query. When the subsystem
+	 * is over budget the result may be from an earlier frame, in which case bNewResult is false and it is drawn faded by age.
+	 */
+	void ReceiveBatchedResult(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result, bool bNewResult, float ResultAge);
+
+	/** Hits or overlaps of the last multi query result, when bDiffHits is set. */
+	const FCollisionQueryHitSet& GetHitSet() const { return HitSet; }
+
+	/** Broadcast with the hits or overlaps which were added, removed or changed by each new result, when bDiffHits is set. */
+	FOnCollisionQueryHitSetChanged OnHitSetChanged;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	/** Rebuilds QueryDesc from the current settings of the actor. */
+	void UpdateQueryDesc();
+
+	/** Whether bDiffHits applies to the query, ie. it is a multi query. */
+	bool ShouldDiffHits(const FCollisionQueryTestDesc& Desc) const;
+
+	/** Diffs a new result against the hit set, redraws the retained lines of the entries which changed and broadcasts the changes. */
+	void UpdateHitSet(const FCollisionQueryTestDesc& Desc, const FCollisionQueryTestResult& Result);
+	void ResetHitSet();
+
+	/** Submits the lines drawn since the last flush to the world's line batcher. */
+	void FlushDebugLines() const;
+
+	/** Darkens the lines drawn since FirstLine according to the age of the result they show. */
+	void FadeDebugLines(int32 FirstLine, float ResultAge) const;
+
+	/** Draws a hit point with DrawDebugPoint, or as lines in DebugLines when drawing with the result component. */
+	void DrawHitPoint(const FVector& Position, float Size, const FColor& Color) const;
+
+	bool CanReuseCachedResult(const FCollisionQueryTestDesc& Desc, uint32 QueryHash, const FVector& Start, const FVector& End);
+	bool AreMovableObjectsNearby(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End) const;
+	void DrawLatencyStats(const FCollisionQueryTestDesc& Desc) const;
+
+	void TickPattern(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot);
+	void BuildPattern(const FVector& Start, const FVector& End);
+	void DrawPattern(const FCollisionQueryTestDesc& Desc, const FQuat& Rot) const;
+	const FVector& GetPatternOverlapPos(int32 QueryIdx) const;
+
+	void TickPath(const FCollisionQueryTestDesc& Desc, const FQuat& Rot);
+	void DrawPath(const FCollisionQueryTestDesc& Desc, const FQuat& Rot, int32 NumQueried, double PathTime) const;
+
+	void TickCompare(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot);
+	void DrawCompareTable(int32 BaselineIdx) const;
+
+	void TickPhaseBreakdown(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot);
+	void DrawPhaseBreakdown() const;
+
+	void TickTraversal(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot);
+	void DrawTraversal() const;
+
+	void TickRawCompare(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot);
+	void DrawRawCompare(double WorldTime, double RawTime) const;
+
+	void TickStressTest(const FCollisionQueryTestDesc& Desc, const FVector& Start);
+	void DrawStressTest(const FBox& Bounds) const;
+
+	void TickHeatmap(const FCollisionQueryTestDesc& Desc, const FVector& Start, const FQuat& Rot);
+	void UpdateHeatmapDirtyCells(const FVector& Center, const FQuat& Rot, const FVector& Extent);
+	void DrawHeatmap(const FVector& Center, const FQuat& Rot, const FVector& Extent) const;
+
+	void OnAsyncTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+	void OnAsyncOverlapCompleted(const FTraceHandle& Handle, FOverlapDatum& Datum);
+
+	FTraceDelegate AsyncTraceDelegate;
+	FOverlapDelegate AsyncOverlapDelegate;
+
+	/** Result of the last async query. The datum's arrays are copied into it rather than moved, so both keep their capacity. */
+	FCollisionQueryTestResult AsyncResult;
+
+	/** Prebuilt query description, see GetQueryDesc. */
+	FCollisionQueryTestDesc QueryDesc;
+
+	FCollisionQueryTestPatternBuffer PatternBuffer;
+
+	TArray<FVector> PathPoints;
+	TArray<FCollisionQueryTestResult> PathResults;
+
+	TArray<FCollisionQueryTestDesc> CompareVariants;
+	TArray<FCollisionQueryTestResult> CompareResults;
+	TArray<double> CompareTimes;
+
+	FCollisionQueryPhaseBreakdown PhaseBreakdown;
+
+	FCollisionQueryTraversal Traversal;
+
+	FCollisionQueryHitSet HitSet;
+	TArray<FBatchedLine> HitSetLines;
+
+	/** Rebuilt only when the settings of the query change, so that the raw path does not pay for the conversions. */
+	FCollisionQueryTestRawDesc RawDesc;
+	uint32 RawDescHash = 0;
+	FCollisionQueryTestResult WorldPathResult;
+	FCollisionQueryTestResult RawPathResult;
+
+	FCollisionQueryStressTest StressTest;
+	TArray<int32> StressThreadCounts;
+	TArray<FCollisionQueryStressTestResult> StressResults;
+	int32 NextStressRun = 0;
+	uint32 StressSettingsHash = 0;
+
+	FCollisionQueryTestVoxelGrid HeatmapGrid;
+	TArray<int32> HeatmapDirtyCells;
+	TArray<uint8> HeatmapSamples;
+	TArray<double> HeatmapExecutionTimes;
+	TArray<FOverlapResult> HeatmapOverlaps;
+
+	FCollisionQueryLatencyHistory LatencyHistory;
+
+	/** Lines drawn this frame, submitted together by FlushDebugLines to the line batcher or result component. */
+	mutable TArray<FBatchedLine> DebugLines;
+
+	FCollisionQueryTestResult QueryResult;
+	uint32 QueryResultHash = 0;
+	double QueryResultTime = 0.0;
+	bool bHasQueryResult = false;
+
 };
\ No newline at end of file
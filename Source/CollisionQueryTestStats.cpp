@@ -0,0 +1,90 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryTestStats.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryTestStats.h"
+
+FString FCollisionQueryLatencySummary::ToString() const
+{
+	return FString::Printf(TEXT("min %.1f avg %.1f p95 %.1f p99 %.1f max %.1f us (%d)"),
+		Min * 1e6, Avg * 1e6, P95 * 1e6, P99 * 1e6, Max * 1e6, NumSamples);
+}
+
+FCollisionQueryLatencyHistory::FCollisionQueryLatencyHistory(int32 InMaxSamples)
+{
+	SetMaxSamples(InMaxSamples);
+}
+
+void FCollisionQueryLatencyHistory::SetMaxSamples(int32 InMaxSamples)
+{
+	InMaxSamples = FMath::Max(InMaxSamples, 1);
+	if (InMaxSamples != MaxSamples)
+	{
+		MaxSamples = InMaxSamples;
+		Reset();
+	}
+	Samples.Reserve(MaxSamples);
+}
+
+void FCollisionQueryLatencyHistory::AddSample(double Seconds)
+{
+	if (Samples.Num() < MaxSamples)
+	{
+		Samples.Add(Seconds);
+	}
+	else
+	{
+		Samples[NextSampleIdx] = Seconds;
+	}
+	NextSampleIdx = (NextSampleIdx + 1) % MaxSamples;
+}
+
+void FCollisionQueryLatencyHistory::Reset()
+{
+	Samples.Reset();
+	NextSampleIdx = 0;
+}
+
+FCollisionQueryLatencySummary FCollisionQueryLatencyHistory::Summarize() const
+{
+	TArray<double> SortedSamples = Samples;
+	return Summarize(SortedSamples);
+}
+
+FCollisionQueryLatencySummary FCollisionQueryLatencyHistory::Summarize(TArray<double>& InOutSamples)
+{
+	FCollisionQueryLatencySummary Summary;
+	Summary.NumSamples = InOutSamples.Num();
+	if (Summary.NumSamples == 0)
+	{
+		return Summary;
+	}
+
+	InOutSamples.Sort();
+
+	double Total = 0.0;
+	for (const double Sample : InOutSamples)
+	{
+		Total += Sample;
+	}
+
+	// nearest-rank percentiles
+	const auto Percentile = [&InOutSamples](double P)
+	{
+		const int32 Rank = static_cast<int32>(FMath::CeilToDouble(P * InOutSamples.Num())) - 1;
+		return InOutSamples[FMath::Clamp(Rank, 0, InOutSamples.Num() - 1)];
+	};
+
+	Summary.Min = InOutSamples[0];
+	Summary.Avg = Total / Summary.NumSamples;
+	Summary.P95 = Percentile(0.95);
+	Summary.P99 = Percentile(0.99);
+	Summary.Max = InOutSamples.Last();
+
+	return Summary;
+}
@@ -0,0 +1,57 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryTestStats.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("CollisionQueryTest"), STATGROUP_CollisionQueryTest, STATCAT_Advanced);
+
+/**
+ * Summary of a set of query latency samples. All times are in seconds.
+ */
+struct FCollisionQueryLatencySummary
+{
+	int32 NumSamples = 0;
+	double Min = 0.0;
+	double Avg = 0.0;
+	double P95 = 0.0;
+	double P99 = 0.0;
+	double Max = 0.0;
+
+	/** Formats the summary in microseconds, eg. "min 4.1 avg 5.3 p95 7.9 p99 12.0 max 14.2 us (128)" */
+	FString ToString() const;
+};
+
+/**
+ * Rolling window holding the last N query latency samples.
+ */
+class FCollisionQueryLatencyHistory
+{
+public:
+	explicit FCollisionQueryLatencyHistory(int32 InMaxSamples = 128);
+
+	void SetMaxSamples(int32 InMaxSamples);
+	void AddSample(double Seconds);
+	void Reset();
+
+	int32 Num() const { return Samples.Num(); }
+
+	/** Sorts a copy of the samples to find the percentiles, so only call this when the result is needed. */
+	FCollisionQueryLatencySummary Summarize() const;
+
+	/** Summarizes an arbitrary set of samples. The samples are sorted in place. */
+	static FCollisionQueryLatencySummary Summarize(TArray<double>& InOutSamples);
+
+private:
+	TArray<double> Samples;
+	int32 MaxSamples = 128;
+	int32 NextSampleIdx = 0;
+};
@@ -0,0 +1,237 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryTestSubsystem.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryTestSubsystem.h"
+#include "CollisionQueryTestStats.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Subsystem Gather"), STAT_CollisionQueryTest_SubsystemGather, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Subsystem Execute"), STAT_CollisionQueryTest_SubsystemExecute, STATGROUP_CollisionQueryTest);
+DECLARE_CYCLE_STAT(TEXT("Subsystem Draw"), STAT_CollisionQueryTest_SubsystemDraw, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Queries"), STAT_CollisionQueryTest_BatchedQueries, STATGROUP_CollisionQueryTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deferred Queries"), STAT_CollisionQueryTest_DeferredQueries, STATGROUP_CollisionQueryTest);
+
+static TAutoConsoleVariable<bool> CVarCollisionQueryTestTickInSubsystem(
+	TEXT("CollisionQueryTest.TickInSubsystem"),
+	true,
+	TEXT("Run the queries of CollisionQueryTestActors as one batch from UCollisionQueryTestSubsystem instead of from each actor's tick."));
+
+static TAutoConsoleVariable<bool> CVarCollisionQueryTestSubsystemParallel(
+	TEXT("CollisionQueryTest.SubsystemParallel"),
+	true,
+	TEXT("Execute the batched queries of UCollisionQueryTestSubsystem across worker threads."));
+
+static TAutoConsoleVariable<float> CVarCollisionQueryTestBudgetMicroseconds(
+	TEXT("CollisionQueryTest.BudgetMicroseconds"),
+	0.f,
+	TEXT("Time the batched queries of UCollisionQueryTestSubsystem may take per frame, in microseconds. Queries which do not fit are run on later frames. 0 for no limit."));
+
+static TAutoConsoleVariable<int32> CVarCollisionQueryTestBudgetQueries(
+	TEXT("CollisionQueryTest.BudgetQueries"),
+	0,
+	TEXT("Number of batched queries UCollisionQueryTestSubsystem may run per frame. Queries which do not fit are run on later frames. 0 for no limit."));
+
+static FAutoConsoleCommandWithWorldAndArgs CollisionQueryTestRecordCommand(
+	TEXT("CollisionQueryTest.Record"),
+	TEXT("Start recording the queries of CollisionQueryTestActors to a file, for replay with the CollisionQueryBenchmark commandlet. Usage: CollisionQueryTest.Record [Filename]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCollisionQueryTestSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionQueryTestSubsystem>() : nullptr)
+		{
+			const FString Filename = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("CollisionQueryRecordings") / FDateTime::Now().ToString() + TEXT(".cqrec");
+			Subsystem->GetRecorder().BeginRecording(Filename, World);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CollisionQueryTestStopRecordingCommand(
+	TEXT("CollisionQueryTest.StopRecording"),
+	TEXT("Stop recording the queries of CollisionQueryTestActors."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UCollisionQueryTestSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionQueryTestSubsystem>() : nullptr)
+		{
+			Subsystem->GetRecorder().EndRecording();
+		}
+	}));
+
+void UCollisionQueryTestSubsystem::RegisterActor(ACollisionQueryTestActor* Actor)
+{
+	if (!Items.ContainsByPredicate([Actor](const FCollisionQueryTestBatchItem& Item) { return Item.Actor == Actor; }))
+	{
+		Items.AddDefaulted_GetRef().Actor = Actor;
+	}
+}
+
+void UCollisionQueryTestSubsystem::UnregisterActor(ACollisionQueryTestActor* Actor)
+{
+	const int32 ItemIdx = Items.IndexOfByPredicate([Actor](const FCollisionQueryTestBatchItem& Item) { return Item.Actor == Actor; });
+	if (ItemIdx != INDEX_NONE)
+	{
+		if (Items[ItemIdx].bBatched)
+		{
+			Actor->SetActorTickEnabled(true);
+		}
+		Items.RemoveAtSwap(ItemIdx);
+	}
+}
+
+void UCollisionQueryTestSubsystem::RecordQuery(const AActor* Actor, const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result)
+{
+	Recorder.RecordQuery(Actor, Desc, Start, End, Rot, Result);
+}
+
+void UCollisionQueryTestSubsystem::Deinitialize()
+{
+	Recorder.EndRecording();
+
+	Super::Deinitialize();
+}
+
+void UCollisionQueryTestSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	GatherQueries();
+	ExecuteQueries();
+	ReturnResults();
+}
+
+TStatId UCollisionQueryTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCollisionQueryTestSubsystem, STATGROUP_Tickables);
+}
+
+void UCollisionQueryTestSubsystem::GatherQueries()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_SubsystemGather);
+
+	const bool bTickInSubsystem = CVarCollisionQueryTestTickInSubsystem.GetValueOnGameThread();
+
+	BatchedItems.Reset();
+
+	Items.RemoveAllSwap([](const FCollisionQueryTestBatchItem& Item) { return !Item.Actor.IsValid(); });
+
+	for (int32 ItemIdx = 0; ItemIdx < Items.Num(); ++ItemIdx)
+	{
+		FCollisionQueryTestBatchItem& Item = Items[ItemIdx];
+		ACollisionQueryTestActor* Actor = Item.Actor.Get();
+
+		// actors in modes which do more than a single query keep ticking on their own
+		const bool bBatch = bTickInSubsystem && Actor->CanTickInSubsystem();
+		if (bBatch != Item.bBatched)
+		{
+			Actor->SetActorTickEnabled(!bBatch);
+			Item.bBatched = bBatch;
+			Item.bHasResult = false;
+		}
+
+		Item.bExecutedThisFrame = false;
+
+		if (bBatch)
+		{
+			BatchedItems.Add(ItemIdx);
+		}
+	}
+}
+
+void UCollisionQueryTestSubsystem::ExecuteQueries()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_SubsystemExecute);
+
+	const int32 NumBatched = BatchedItems.Num();
+	if (NumBatched == 0)
+	{
+		return;
+	}
+
+	const double BudgetSeconds = CVarCollisionQueryTestBudgetMicroseconds.GetValueOnGameThread() * 1e-6;
+	const int32 BudgetQueries = CVarCollisionQueryTestBudgetQueries.GetValueOnGameThread();
+	const int32 MaxQueries = BudgetQueries > 0 ? FMath::Min(BudgetQueries, NumBatched) : NumBatched;
+
+	// with a time budget the queries are run in chunks, checking the time taken after each
+	const int32 ChunkSize = BudgetSeconds > 0.0 ? 32 : MaxQueries;
+
+	const EParallelForFlags Flags = CVarCollisionQueryTestSubsystemParallel.GetValueOnGameThread() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+	UWorld* World = GetWorld();
+	const double ResultTime = World->GetTimeSeconds();
+	TArray<FCollisionQueryTestBatchItem>& BatchItems = Items;
+
+	NextBatchedItem = NextBatchedItem % NumBatched;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	int32 NumExecuted = 0;
+
+	while (NumExecuted < MaxQueries)
+	{
+		ChunkItems.Reset();
+		for (int32 ChunkIdx = 0; ChunkIdx < ChunkSize && NumExecuted + ChunkIdx < MaxQueries; ++ChunkIdx)
+		{
+			const int32 ItemIdx = BatchedItems[(NextBatchedItem + NumExecuted + ChunkIdx) % NumBatched];
+			ChunkItems.Add(ItemIdx);
+
+			FCollisionQueryTestBatchItem& Item = Items[ItemIdx];
+			const ACollisionQueryTestActor* Actor = Item.Actor.Get();
+			Item.Desc = Actor->GetQueryDesc();
+			Item.Start = Actor->GetActorLocation();
+			Item.End = Actor->EndComponent->GetComponentLocation();
+			Item.Rot = Actor->GetActorQuat();
+			Item.ResultTime = ResultTime;
+			Item.bHasResult = true;
+			Item.bExecutedThisFrame = true;
+		}
+
+		const TArray<int32>& Chunk = ChunkItems;
+		ParallelFor(Chunk.Num(), [World, &BatchItems, &Chunk](int32 ChunkIdx)
+		{
+			FCollisionQueryTestBatchItem& Item = BatchItems[Chunk[ChunkIdx]];
+			Item.Desc.Execute(World, Item.Start, Item.End, Item.Rot, Item.Result);
+		}, Flags);
+
+		NumExecuted += Chunk.Num();
+
+		if (BudgetSeconds > 0.0 && FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) >= BudgetSeconds)
+		{
+			break;
+		}
+	}
+
+	NextBatchedItem = (NextBatchedItem + NumExecuted) % NumBatched;
+
+	SET_DWORD_STAT(STAT_CollisionQueryTest_BatchedQueries, NumExecuted);
+	SET_DWORD_STAT(STAT_CollisionQueryTest_DeferredQueries, NumBatched - NumExecuted);
+}
+
+void UCollisionQueryTestSubsystem::ReturnResults()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CollisionQueryTest_SubsystemDraw);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	for (const int32 ItemIdx : BatchedItems)
+	{
+		const FCollisionQueryTestBatchItem& Item = Items[ItemIdx];
+		ACollisionQueryTestActor* Actor = Item.Actor.Get();
+		if (!Actor || !Item.bHasResult)
+		{
+			continue;
+		}
+
+		if (Item.bExecutedThisFrame)
+		{
+			Recorder.RecordQuery(Actor, Item.Desc, Item.Start, Item.End, Item.Rot, Item.Result);
+		}
+
+		const float ResultAge = static_cast<float>(Now - Item.ResultTime);
+		Actor->ReceiveBatchedResult(Item.Desc, Item.Start, Item.End, Item.Rot, Item.Result, Item.bExecutedThisFrame, ResultAge);
+	}
+}
@@ -0,0 +1,86 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryTestSubsystem.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CollisionQueryTestActor.h"
+#include "CollisionQueryRecording.h"
+
+#include "CollisionQueryTestSubsystem.generated.h"
+
+/**
+ * A registered test actor and the last query the subsystem ran for it.
+ */
+struct FCollisionQueryTestBatchItem
+{
+	TWeakObjectPtr<ACollisionQueryTestActor> Actor;
+	FCollisionQueryTestDesc Desc;
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FQuat Rot = FQuat::Identity;
+	FCollisionQueryTestResult Result;
+
+	double ResultTime = 0.0;		// world time the result was found at, to tell how stale it is
+	bool bHasResult = false;
+	bool bExecutedThisFrame = false;
+	bool bBatched = false;			// whether the actor is currently batched, ie. has its own tick disabled
+};
+
+/**
+ * Runs the queries of all CollisionQueryTestActors in the world as one batch, instead of each actor ticking and
+ * querying on its own. Actors register in BeginPlay. Each frame the subsystem executes the queries of actors that can be
+ * batched in one pass (across worker threads unless CollisionQueryTest.SubsystemParallel is 0), then hands the results
+ * back to the actors to draw. Actors have their own tick disabled while they are batched.
+ *
+ * The batch can be limited to a per-frame budget with CollisionQueryTest.BudgetMicroseconds and/or
+ * CollisionQueryTest.BudgetQueries. Queries which do not fit are run on later frames, round-robin, and meanwhile their
+ * last result is drawn fading out with age.
+ *
+ * Set CollisionQueryTest.TickInSubsystem to 0 to go back to ticking each actor on its own.
+ *
+ * Also owns the recorder started by CollisionQueryTest.Record, which records every synchronous query the test actors
+ * perform (pattern and async queries are not recorded).
+ */
+UCLASS()
+class UCollisionQueryTestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterActor(ACollisionQueryTestActor* Actor);
+	void UnregisterActor(ACollisionQueryTestActor* Actor);
+
+	/** Adds a query to the recording, if one is in progress. */
+	void RecordQuery(const AActor* Actor, const FCollisionQueryTestDesc& Desc, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionQueryTestResult& Result);
+
+	FCollisionQueryRecorder& GetRecorder() { return Recorder; }
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	void GatherQueries();
+	void ExecuteQueries();
+	void ReturnResults();
+
+	/** One item per registered actor. */
+	TArray<FCollisionQueryTestBatchItem> Items;
+
+	/** Indices of the items which are batched this frame, in round-robin order. */
+	TArray<int32> BatchedItems;
+	TArray<int32> ChunkItems;
+
+	/** Index into BatchedItems of the first query to run next frame. */
+	int32 NextBatchedItem = 0;
+
+	FCollisionQueryRecorder Recorder;
+};
@@ -0,0 +1,250 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryTraversal.cpp
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#include "CollisionQueryTraversal.h"
+#include "CollisionQueryTestActor.h"
+#include "Chaos/CollisionFilterData.h"
+#include "Chaos/ISpatialAcceleration.h"
+#include "Chaos/ParticleHandle.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+#include "Physics/Experimental/ChaosInterfaceWrapper.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "Physics/PhysicsFiltering.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "PhysicsEngine/BodyInstance.h"
+
+namespace CollisionQueryTraversal
+{
+	using FAccelerationStructure = Chaos::ISpatialAcceleration<Chaos::FAccelerationStructureHandle, Chaos::FReal, 3>;
+	using FVisitorData = Chaos::TSpatialVisitorData<Chaos::FAccelerationStructureHandle>;
+
+	/** Counts every element the traversal reaches, without testing any of them, so that the whole query length is traversed. */
+	class FCountingVisitor : public Chaos::ISpatialVisitor<Chaos::FAccelerationStructureHandle, Chaos::FReal>
+	{
+	public:
+		FCountingVisitor(TArray<FCollisionQueryTraversalLeaf>& InLeaves, const FCollisionQueryTraversalFilter& InFilter)
+			: Leaves(InLeaves)
+			, Filter(InFilter)
+		{
+		}
+
+		virtual bool Overlap(const FVisitorData& Instance) override
+		{
+			Visit(Instance);
+			return true;
+		}
+
+		virtual bool Raycast(const FVisitorData& Instance, Chaos::FQueryFastData& CurData) override
+		{
+			Visit(Instance);
+			return true;
+		}
+
+		virtual bool Sweep(const FVisitorData& Instance, Chaos::FQueryFastData& CurData) override
+		{
+			Visit(Instance);
+			return true;
+		}
+
+	private:
+		void Visit(const FVisitorData& Instance)
+		{
+			const Chaos::FGeometryParticle* Particle = Instance.Payload.GetExternalGeometryParticle_ExternalThread();
+
+			int32& LeafIdx = LeafIndices.FindOrAdd(Particle, INDEX_NONE);
+			if (LeafIdx == INDEX_NONE)
+			{
+				LeafIdx = Leaves.AddDefaulted();
+				FCollisionQueryTraversalLeaf& Leaf = Leaves[LeafIdx];
+				if (Instance.bHasBounds)
+				{
+					Leaf.Bounds = FBox(FVector(Instance.Bounds.Min()), FVector(Instance.Bounds.Max()));
+				}
+				if (Particle)
+				{
+					if (const FBodyInstance* BodyInstance = FChaosUserData::Get<FBodyInstance>(Particle->UserData()))
+					{
+						Leaf.Component = BodyInstance->OwnerComponent.Get();
+					}
+
+					for (const TUniquePtr<Chaos::FPerShapeData>& Shape : Particle->ShapesArray())
+					{
+						Leaf.NumShapes += Shape->GetQueryEnabled() && Filter.Passes(Shape->GetQueryData()) ? 1 : 0;
+					}
+				}
+			}
+
+			++Leaves[LeafIdx].NumVisits;
+		}
+
+		TArray<FCollisionQueryTraversalLeaf>& Leaves;
+		const FCollisionQueryTraversalFilter& Filter;
+		TMap<const Chaos::FGeometryParticle*, int32> LeafIndices;
+	};
+
+#if !UE_BUILD_SHIPPING
+	/** Collects the bounds the structure draws for its nodes. */
+	class FNodeCollector : public Chaos::ISpacialDebugDrawInterface<Chaos::FReal>
+	{
+	public:
+		explicit FNodeCollector(TArray<FBox>& InBoxes)
+			: Boxes(InBoxes)
+		{
+		}
+
+		virtual void Box(const Chaos::FAABB3& InBox, const Chaos::FVec3& InLinearColor, float InThickness) override
+		{
+			Boxes.Emplace(FVector(InBox.Min()), FVector(InBox.Max()));
+		}
+
+		virtual void Line(const Chaos::FVec3& InBegin, const Chaos::FVec3& InEnd, const Chaos::FVec3& InLinearColor, float InThickness) override
+		{
+		}
+
+	private:
+		TArray<FBox>& Boxes;
+	};
+#endif
+}
+
+FCollisionQueryTraversalFilter FCollisionQueryTraversalFilter::Make(const FCollisionQueryTestDesc& Desc)
+{
+	FCollisionQueryTraversalFilter Filter;
+	if (Desc.By == ECollisionQueryTestBy::ObjectType)
+	{
+		Filter.bByObjectType = true;
+		Filter.ObjectTypes = Desc.ObjectQueryParams.GetQueryBitfield();
+	}
+	else if (Desc.By == ECollisionQueryTestBy::Profile)
+	{
+		// queries by profile are made on the profile's object type with its responses, as UWorld does
+		FCollisionResponseTemplate Template;
+		if (UCollisionProfile::Get()->GetProfileTemplate(Desc.CollisionProfileName, Template))
+		{
+			Filter.Channel = Template.ObjectType;
+			Filter.Responses = Template.ResponseToChannels;
+		}
+		else
+		{
+			Filter.Responses.SetAllChannels(ECR_Ignore);
+		}
+	}
+	else
+	{
+		Filter.Channel = Desc.Channel;
+		Filter.Responses = Desc.ResponseParams.CollisionResponse;
+	}
+	return Filter;
+}
+
+bool FCollisionQueryTraversalFilter::Passes(const FCollisionFilterData& ShapeData) const
+{
+	// the shape's object type is in the top bits of Word3, and the channels it blocks and touches in Word1 and Word2
+	const ECollisionChannel ShapeType = GetCollisionChannel(ShapeData.Word3);
+	if (bByObjectType)
+	{
+		return (ObjectTypes & ECC_TO_BITFIELD(ShapeType)) != 0;
+	}
+
+	return Responses.GetResponse(ShapeType) != ECR_Ignore && ((ShapeData.Word1 | ShapeData.Word2) & ECC_TO_BITFIELD(Channel)) != 0;
+}
+
+void FCollisionQueryTraversal::Record(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionShape& Shape, bool bOverlap, const FCollisionQueryTraversalFilter& Filter, bool bGatherNodes)
+{
+	using namespace CollisionQueryTraversal;
+
+	Reset();
+
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+	if (!PhysScene)
+	{
+		return;
+	}
+
+	// the query's world space bounds at the start, swept along to the end for traces and sweeps
+	const FVector HalfExtent = Shape.IsLine() ? FVector::ZeroVector : FBox(-Shape.GetExtent(), Shape.GetExtent()).TransformBy(FTransform(Rot)).GetExtent();
+	const FVector Delta = End - Start;
+	const double Length = Delta.Size();
+	const FVector Dir = Length > UE_SMALL_NUMBER ? Delta / Length : FVector::ForwardVector;
+
+	FPhysicsCommand::ExecuteRead(PhysScene, [&]()
+	{
+		const FAccelerationStructure* Accel = PhysScene->GetSpacialAcceleration();
+		if (!Accel)
+		{
+			return;
+		}
+
+		FCountingVisitor Visitor(Leaves, Filter);
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		if (bOverlap)
+		{
+			Accel->Overlap(Chaos::FAABB3(Start - HalfExtent, Start + HalfExtent), Visitor);
+		}
+		else if (HalfExtent.IsNearlyZero())
+		{
+			// zero size sweeps are made as line traces by the scene query too
+			Accel->Raycast(Start, Dir, Length, Visitor);
+		}
+		else
+		{
+			Accel->Sweep(Start, Dir, Length, HalfExtent, Visitor);
+		}
+		TraversalTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+#if !UE_BUILD_SHIPPING
+		if (bGatherNodes)
+		{
+			// the structure reports the elements a traversal reaches but not the nodes it passes through on the way, so the
+			// nodes are taken from its debug draw instead and kept if the query's bounds pass through them
+			TArray<FBox> Boxes;
+			FNodeCollector Collector(Boxes);
+			Accel->DebugDraw(&Collector);
+
+			const FBox QueryBox(Start - HalfExtent, Start + HalfExtent);
+			for (const FBox& Box : Boxes)
+			{
+				const bool bVisited = bOverlap
+					? Box.Intersect(QueryBox)
+					: FMath::LineBoxIntersection(Box.ExpandBy(HalfExtent), Start, End, Delta);
+				if (bVisited)
+				{
+					Nodes.AddDefaulted_GetRef().Bounds = Box;
+				}
+			}
+		}
+#endif
+	});
+
+	for (const FCollisionQueryTraversalLeaf& Leaf : Leaves)
+	{
+		NumVisits += Leaf.NumVisits;
+		NumTests += Leaf.GetNumTests();
+
+		if (Leaf.Bounds.IsValid)
+		{
+			const FVector Center = Leaf.Bounds.GetCenter();
+			for (FCollisionQueryTraversalNode& Node : Nodes)
+			{
+				Node.NumLeaves += Node.Bounds.IsInsideOrOn(Center) ? 1 : 0;
+			}
+		}
+	}
+}
+
+void FCollisionQueryTraversal::Reset()
+{
+	Nodes.Reset();
+	Leaves.Reset();
+	NumVisits = 0;
+	NumTests = 0;
+	TraversalTime = 0.0;
+}
@@ -0,0 +1,84 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) Studio Gobo Ltd 2026
+// Licensed under the MIT license.  
+// See LICENSE.TXT in the project root for license information.
+// ----------------------------------------------------------------------------
+// File			-> CollisionQueryTraversal.h
+// Created		-> October 2026
+// Author		-> George Prosser (Studio Gobo)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "CollisionShape.h"
+#include "UObject/ObjectKey.h"
+
+class UWorld;
+struct FCollisionFilterData;
+struct FCollisionQueryTestDesc;
+
+/**
+ * The filter the scene query applies to each shape before its narrowphase: for queries by object type, whether the
+ * shape is one of the queried types, and otherwise whether the query and shape both respond to each other.
+ */
+struct FCollisionQueryTraversalFilter
+{
+	bool bByObjectType = false;
+	int32 ObjectTypes = 0;					// bitfield of queried object types, for queries by object type
+	ECollisionChannel Channel = ECC_WorldStatic;	// channel of the query, for queries by channel or profile
+	FCollisionResponseContainer Responses;	// responses of the query to each object type, for queries by channel or profile
+
+	/** Builds the filter of a query, resolving its profile for queries by profile. */
+	static FCollisionQueryTraversalFilter Make(const FCollisionQueryTestDesc& Desc);
+
+	/** Whether the query would test a shape with the given query filter data. */
+	bool Passes(const FCollisionFilterData& ShapeData) const;
+};
+
+/**
+ * An element of the scene query acceleration structure (the bounds of one physics particle) which a traversal reached.
+ */
+struct FCollisionQueryTraversalLeaf
+{
+	FBox Bounds = FBox(ForceInit);
+	FObjectKey Component;	// component owning the particle's body, if it has one
+	int32 NumVisits = 0;	// elements spanning several cells or sub-structures are reached more than once
+	int32 NumShapes = 0;	// shapes of the particle which pass the query's filter, each of which the narrowphase tests per visit
+
+	int32 GetNumTests() const { return NumVisits * NumShapes; }
+};
+
+/**
+ * A node of the acceleration structure whose bounds the query passes through.
+ */
+struct FCollisionQueryTraversalNode
+{
+	FBox Bounds = FBox(ForceInit);
+	int32 NumLeaves = 0;	// reached leaves whose bounds are centred inside the node
+};
+
+/**
+ * Records which parts of the world's scene query acceleration structure a query traverses, by repeating its broadphase
+ * directly against the structure with a visitor that counts every element reached, and how many of its shapes pass the
+ * query's filter for the narrowphase to test. Tells a query which is expensive because it is long or large apart from one which is
+ * expensive because the structure is poorly balanced where it is made.
+ */
+struct FCollisionQueryTraversal
+{
+	TArray<FCollisionQueryTraversalNode> Nodes;
+	TArray<FCollisionQueryTraversalLeaf> Leaves;
+
+	int32 NumVisits = 0;
+	int32 NumTests = 0;		// filtered shapes tested over all visits
+	double TraversalTime = 0.0;
+
+	/**
+	 * Traverses the structure for a line trace or sweep of Shape from Start to End, or an overlap of Shape at Start. The
+	 * traversal is not clipped by hits, so End should be clipped to the blocking hit of the query to match what it visits.
+	 * Nodes are only gathered when bGatherNodes is set and outside of shipping builds.
+	 */
+	void Record(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rot, const FCollisionShape& Shape, bool bOverlap, const FCollisionQueryTraversalFilter& Filter, bool bGatherNodes);
+
+	void Reset();
+};